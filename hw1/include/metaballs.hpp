@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <random>
 #include "utils.hpp"
 
@@ -56,12 +58,14 @@ private:
 
 public:
 
-    inline explicit metaballs_graph(float x0, float x1, float y0, float y1, int n = 1) {
+    // a fixed seed gives the same metaballs on every run
+    inline explicit metaballs_graph(float x0, float x1, float y0, float y1, int n = 1,
+                                    std::optional<std::uint32_t> seed = std::nullopt) {
         this->x0 = x0;
         this->x1 = x1;
         this->y0 = y0;
         this->y1 = y1;
-        mers = std::mt19937(rd());
+        mers = std::mt19937(seed.has_value() ? seed.value() : rd());
         dist = std::uniform_real_distribution<float>(0.f, 1.f);
 
         max_r = std::min(x1 - x0, y1 - y0) / 10;
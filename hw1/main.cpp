@@ -10,9 +10,9 @@
 #include <string_view>
 #include <stdexcept>
 #include <iostream>
-#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <vector>
-#include <map>
 #include <cmath>
 
 #include "graph_fragment_shader.h"
@@ -25,57 +25,40 @@
 #include "utils.hpp"
 #include "isoline.hpp"
 #include "graph.hpp"
+#include "engine/frame_loop.hpp"
+#ifdef WITH_HEADLESS
+#include "headless.hpp"
+#endif
 
 using std::cos, std::sin;
 
-std::string to_string(std::string_view str) {
-    return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message) {
-    throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error) {
-    throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
-int main() try {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
-        sdl2_fail("SDL_Init: ");
-
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-    SDL_Window *window = SDL_CreateWindow("Metaballs3D",
-                                          SDL_WINDOWPOS_CENTERED,
-                                          SDL_WINDOWPOS_CENTERED,
-                                          800, 600,
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-    if (!window)
-        sdl2_fail("SDL_CreateWindow: ");
-
-    int width, height;
-    SDL_GetWindowSize(window, &width, &height);
-
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-    if (!gl_context)
-        sdl2_fail("SDL_GL_CreateContext: ");
-
-    if (auto result = glewInit(); result != GLEW_NO_ERROR)
-        glew_fail("glewInit: ", result);
-
-    if (!GLEW_VERSION_3_3)
-        throw std::runtime_error("OpenGL 3.3 is not supported");
+int main(int argc, char **argv) try {
+    // --headless N renders N frames without a window, turning the graph around,
+    // and writes them with their timings to --output
+    int headless_frames = 0;
+    std::filesystem::path output_directory = ".";
+    int width = 1280, height = 720;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--headless" && i + 1 < argc) {
+            headless_frames = std::stoi(argv[++i]);
+        }
+        if (arg == "--output" && i + 1 < argc) {
+            output_directory = argv[++i];
+        }
+        if (arg == "--size" && i + 1 < argc && std::sscanf(argv[++i], "%dx%d", &width, &height) != 2) {
+            throw std::runtime_error("--size expects WIDTHxHEIGHT");
+        }
+    }
+    bool headless = headless_frames > 0;
+
+    render_context context({.title = "Metaballs3D", .width = width, .height = height, .samples = headless ? 0 : 4,
+                            .headless = headless});
+    width = context.get_width();
+    height = context.get_height();
+    if (headless) {
+        std::filesystem::create_directories(output_directory);
+    }
 
     glClearColor(0.f, 0.f, 0.f, 0.f);
     glEnable(GL_DEPTH_TEST);
@@ -122,7 +105,9 @@ int main() try {
     uint32_t grid_height = 50;
     int balls_count = 30;
 
-    auto func = metaballs_graph(x0, x1, y0, y1, balls_count);
+    auto func = headless
+        ? metaballs_graph(x0, x1, y0, y1, balls_count, 0)
+        : metaballs_graph(x0, x1, y0, y1, balls_count);
 
     auto[grid, graph_order] = build_grid(grid_width, grid_height);
 
@@ -184,8 +169,6 @@ int main() try {
 
     // End
 
-    auto last_frame_start = std::chrono::high_resolution_clock::now();
-
     float time = 0.f;
 
     float near = 0.001f;
@@ -199,99 +182,97 @@ int main() try {
     changed_value angle_x{0.9f, 1.f};
     bool pause = false;
 
-    std::map<SDL_Keycode, bool> button_down;
-
-    bool running = true;
-    while (running) {
-        int wheel = 0;
-        for (SDL_Event event; SDL_PollEvent(&event);)
-            switch (event.type) {
-                case SDL_QUIT:
-                    running = false;
-                    break;
-                case SDL_WINDOWEVENT:
-                    switch (event.window.event) {
-                        case SDL_WINDOWEVENT_RESIZED:
-                            width = event.window.data1;
-                            height = event.window.data2;
-                            glViewport(0, 0, width, height);
-                            top = right * (float) height / (float) width;
-                            break;
-                    }
-                    break;
-                case SDL_KEYDOWN:
-                    if (event.key.keysym.sym == SDLK_SPACE) {
-                        pause = !pause;
-                    }
-                    if (event.key.keysym.sym == SDLK_LCTRL) {
+#ifdef WITH_HEADLESS
+    frame_timer timer;
+#endif
+    int wheel = 0;
+
+    frame_loop loop(context);
+    loop.on_resize = [&](int new_width, int new_height) {
+        width = new_width;
+        height = new_height;
+        top = right * (float) height / (float) width;
+    };
+    loop.on_event = [&](const SDL_Event &event) {
+        switch (event.type) {
+            case SDL_KEYDOWN:
+                if (event.key.keysym.sym == SDLK_SPACE) {
+                    pause = !pause;
+                }
+                if (event.key.keysym.sym == SDLK_LCTRL) {
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+                }
+                if (event.key.keysym.sym == SDLK_LALT) {
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+                }
+                if (event.key.keysym.sym == SDLK_1) {
+                    isoline_on = !isoline_on;
+                }
+                if (event.key.keysym.sym == SDLK_2) {
+                    grid_on = !grid_on;
+                }
+                break;
+            case SDL_KEYUP:
+                if (event.key.keysym.sym == SDLK_LCTRL || event.key.keysym.sym == SDLK_LALT) {
+                    if (loop.input.is_down(SDL_SCANCODE_LCTRL)) {
                         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                    }
-                    if (event.key.keysym.sym == SDLK_LALT) {
+                    } else if (loop.input.is_down(SDL_SCANCODE_LALT)) {
                         glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+                    } else {
+                        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
                     }
-                    if (event.key.keysym.sym == SDLK_1) {
-                        isoline_on = !isoline_on;
-                    }
-                    if (event.key.keysym.sym == SDLK_2) {
-                        grid_on = !grid_on;
-                    }
-                    button_down[event.key.keysym.sym] = true;
-                    break;
-                case SDL_KEYUP:
-                    button_down[event.key.keysym.sym] = false;
-                    if (event.key.keysym.sym == SDLK_LCTRL || event.key.keysym.sym == SDLK_LALT) {
-                        if (button_down[SDLK_LCTRL]) {
-                            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                        } else if (button_down[SDLK_LALT]) {
-                            glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
-                        } else {
-                            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-                        }
-                    }
-                    break;
-                case SDL_MOUSEWHEEL:
-                    wheel = event.wheel.y;
-                    break;
-                case SDL_MOUSEBUTTONDOWN:
-                    if (event.button.button == SDL_BUTTON_LEFT) {
-                        func.add_metaball();
-                    } else if (event.button.button == SDL_BUTTON_RIGHT) {
-                        func.remove_metaball();
-                    }
-                    break;
-            }
-
-        if (!running)
-            break;
+                }
+                break;
+            case SDL_MOUSEWHEEL:
+                wheel = event.wheel.y;
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+                if (event.button.button == SDL_BUTTON_LEFT) {
+                    func.add_metaball();
+                } else if (event.button.button == SDL_BUTTON_RIGHT) {
+                    func.remove_metaball();
+                }
+                break;
+        }
+    };
+    if (headless) {
+        // fixed steps keep the frames reproducible
+        loop.set_fixed_step(1.f / 60.f);
+    }
 
-        auto now = std::chrono::high_resolution_clock::now();
-        float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-        last_frame_start = now;
+    while (loop.next_frame()) {
+        float dt = loop.get_dt();
+        if (headless) {
+#ifdef WITH_HEADLESS
+            timer.start();
+#endif
+            angle_z.value += 0.5f * angle_z.velocity * dt;
+        }
         if (!pause) {
             time += dt;
         }
 
-        if (button_down[SDLK_RIGHT] | button_down[SDLK_d]) {
+        if (loop.input.is_down(SDL_SCANCODE_RIGHT) | loop.input.is_down(SDL_SCANCODE_D)) {
             angle_z.value += angle_z.velocity * dt;
         }
-        if (button_down[SDLK_LEFT] | button_down[SDLK_a]) {
+        if (loop.input.is_down(SDL_SCANCODE_LEFT) | loop.input.is_down(SDL_SCANCODE_A)) {
             angle_z.value -= angle_z.velocity * dt;
         }
-        if (button_down[SDLK_UP]) {
+        if (loop.input.is_down(SDL_SCANCODE_UP)) {
             angle_x.value += angle_x.velocity * dt;
         }
-        if (button_down[SDLK_DOWN]) {
+        if (loop.input.is_down(SDL_SCANCODE_DOWN)) {
             angle_x.value -= angle_x.velocity * dt;
         }
-        if (button_down[SDLK_w]) {
+        if (loop.input.is_down(SDL_SCANCODE_W)) {
             z.value += z.velocity * dt;
         }
-        if (button_down[SDLK_s]) {
+        if (loop.input.is_down(SDL_SCANCODE_S)) {
             z.value -= z.velocity * dt;
         }
 
         if (wheel != 0) {
-            if (button_down[SDLK_LSHIFT]) {
+            if (loop.input.is_down(SDL_SCANCODE_LSHIFT)) {
                 if (isoline_count + wheel >= 2) {
                     isoline_count += wheel;
                     C.resize(isoline_count);
@@ -311,6 +292,7 @@ int main() try {
                                  GL_DYNAMIC_DRAW);
                 }
             }
+            wheel = 0;
         }
 
         float transform[] = {
@@ -396,11 +378,25 @@ int main() try {
             glDrawArrays(GL_LINES, 0, 2 * (grid_x_size + grid_y_size + 2 * grid_z_size));
         }
 
-        SDL_GL_SwapWindow(window);
+        if (headless) {
+#ifdef WITH_HEADLESS
+            timer.stop();
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%04d.png", loop.get_frame());
+            write_png((output_directory / name).string(), width, height);
+#endif
+            if (loop.get_frame() + 1 == headless_frames) {
+                loop.stop();
+            }
+        }
+        loop.end_frame();
     }
 
-    SDL_GL_DeleteContext(gl_context);
-    SDL_DestroyWindow(window);
+#ifdef WITH_HEADLESS
+    if (headless) {
+        timer.write_csv((output_directory / "timings.csv").string());
+    }
+#endif
 }
 catch (std::exception const &e) {
     std::cerr << e.what() << std::endl;
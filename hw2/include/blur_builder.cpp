@@ -1,67 +1,199 @@
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include <glm/common.hpp>
 #include "blur_builder.hpp"
 #include "blur_vertex_shader.h"
 #include "blur_fragment_shader.h"
+#include "blur_compute_shader.h"
 
-void blur_builder::init(int target_texture, GLuint texture, int format, int width, int height, int fbo) {
-    _width = width;
-    _height = height;
+namespace {
+
+const int tile_size = 128;
+
+// variant of the compute shader declaring the image in format
+int get_image_variant(int format) {
+    switch (format) {
+        case GL_RG32F:
+            return 0;
+        case GL_RG16F:
+            return 1;
+        case GL_RG16:
+            return 2;
+        case GL_RGBA8:
+            return 3;
+        default:
+            throw std::runtime_error("Unsupported blur format!");
+    }
+}
+
+}
+
+void blur_builder::init(render_target_pool &targets, int target_texture, GLuint texture, int format, int width, int height, int fbo) {
+    _targets = &targets;
     _texture = texture;
     _target_texture = target_texture;
+    _format = format;
     _program = shader_program(blur_vertex_shader_source, blur_fragment_shader_source);
 
-    glGenVertexArrays(1, &_vao);
-
-    glActiveTexture(GL_TEXTURE0 + target_texture);
-
-    glGenTextures(1, &_tmp_texture);
-    glBindTexture(GL_TEXTURE_2D, _tmp_texture);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    use_compute = GLEW_ARB_compute_shader && GLEW_ARB_shader_image_load_store;
+    if (use_compute) {
+        _compute_program.init_compute(blur_compute_shader_source);
+        _compute_program.enable_variants();
+        _image_variant = get_image_variant(format);
+    }
 
-    glGenFramebuffers(1, &_fbo_x);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo_x);
-    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _tmp_texture, 0);
-    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        throw std::runtime_error("Incomplete framebuffer!");
+    _vao = gl_vertex_array::create();
+    resize(width, height);
 
     if (fbo == -1) {
-        glGenFramebuffers(1, &_fbo_y);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo_y);
+        _own_fbo = gl_framebuffer::create();
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _own_fbo);
         glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0);
         if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
             throw std::runtime_error("Incomplete framebuffer!");
+        _fbo_y = _own_fbo;
     } else {
         _fbo_y = fbo;
     }
 }
 
-void blur_builder::do_blur(int N, float radius) {
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo_x);
+void blur_builder::resize(int width, int height) {
+    _width = width;
+    _height = height;
+}
+
+void blur_builder::update_weights(int N, float radius) {
+    if (N == _N && radius == _radius) {
+        return;
+    }
+    _N = N;
+    _radius = radius;
+
+    float sum = 0.f;
+    for (int i = 0; i <= N; i++) {
+        _weights[i] = std::exp(-float(i * i) / (radius * radius));
+        sum += i == 0 ? _weights[i] : 2.f * _weights[i];
+    }
+    for (int i = 0; i <= N; i++) {
+        _weights[i] /= sum;
+    }
+
+    // linear filtering between texels i and i + 1 gives both weights with one fetch
+    _tap_weights[0] = _weights[0];
+    _tap_offsets[0] = 0.f;
+    _taps = 1;
+    for (int i = 1; i <= N; i += 2) {
+        float w0 = _weights[i];
+        float w1 = i + 1 <= N ? _weights[i + 1] : 0.f;
+        _tap_weights[_taps] = w0 + w1;
+        _tap_offsets[_taps] = (float(i) * w0 + float(i + 1) * w1) / (w0 + w1);
+        _taps++;
+    }
+}
+
+void blur_builder::do_blur(int N, float radius, int fbo, const std::optional<glm::ivec4>& region) {
+    N = std::clamp(N, 0, max_N);
+    update_weights(N, radius);
+
+    GLuint target_fbo = fbo == -1 ? _fbo_y : fbo;
+    // the first pass result is only needed until the second one is done
+    glActiveTexture(GL_TEXTURE0 + _target_texture);
+    render_target_pool::lease tmp = _targets->acquire(_format, _width, _height);
+    if (use_compute) {
+        glm::ivec4 size(_width, _height, _width, _height);
+        glm::ivec4 r = glm::clamp(region.value_or(glm::ivec4(0, 0, _width, _height)), glm::ivec4(0), size);
+        if (r.z > r.x && r.w > r.y) {
+            do_blur_compute(N, target_fbo, tmp, r);
+        }
+    } else {
+        do_blur_fragment(N, target_fbo, tmp, region);
+    }
+}
+
+void blur_builder::do_blur_fragment(int N, GLuint fbo, const render_target_pool::lease& tmp, const std::optional<glm::ivec4>& region) {
+    if (region.has_value()) {
+        // the second pass reads N texels around the region
+        glm::ivec4 r = region.value();
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(r.x - N, r.y - N, r.z - r.x + 2 * N, r.w - r.y + 2 * N);
+    }
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, tmp.fbo());
     glViewport(0, 0, _width, _height);
     glActiveTexture(GL_TEXTURE0 + _target_texture);
     glBindTexture(GL_TEXTURE_2D, _texture);
 
     _program.bind();
-    glUniform1i(_program["target"], _target_texture);
-    glUniform1i(_program["N"], N);
-    glUniform1f(_program["radius"], radius);
-    glUniform1i(_program["mode"], 0);
+    _program.set("target", _target_texture);
+    _program.set("taps", _taps);
+    _program.set("weights", std::span<const float>(_tap_weights.data(), _taps));
+    _program.set("offsets", std::span<const float>(_tap_offsets.data(), _taps));
+    _program.set("mode", 0);
     glBindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo_y);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    if (region.has_value()) {
+        glm::ivec4 r = region.value();
+        glScissor(r.x, r.y, r.z - r.x, r.w - r.y);
+    }
     glActiveTexture(GL_TEXTURE0 + _target_texture);
-    glBindTexture(GL_TEXTURE_2D, _tmp_texture);
-    glUniform1i(_program["mode"], 1);
+    glBindTexture(GL_TEXTURE_2D, tmp.texture());
+    _program.set("mode", 1);
 
     glBindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    if (region.has_value()) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+void blur_builder::do_blur_compute(int N, GLuint fbo, const render_target_pool::lease& tmp, const glm::ivec4& region) {
+    // the result goes straight into the texture attached to the framebuffer
+    GLint texture = 0;
+    GLint layer = 0;
+    GLint face = 0;
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &texture);
+    glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_LAYER, &layer);
+    glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_CUBE_MAP_FACE, &face);
+    if (face != 0) {
+        layer = face - GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+    }
+
+    // the second pass reads N texels around the region in x
+    glm::ivec4 first(std::max(region.x - N, 0), region.y, std::min(region.z + N, _width), region.w);
+
+    _compute_program.bind();
+    const shader_program &program = _compute_program.select(_image_variant);
+    program.set("target", _target_texture);
+    program.set("result", 0);
+    program.set("N", N);
+    program.set("weights", std::span<const float>(_weights.data(), N + 1));
+    glActiveTexture(GL_TEXTURE0 + _target_texture);
+
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glBindImageTexture(0, tmp.texture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, _format);
+    program.set("mode", 0);
+    program.set("region", first);
+    glDispatchCompute((first.w - first.y + tile_size - 1) / tile_size, first.z - first.x, 1);
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    glBindTexture(GL_TEXTURE_2D, tmp.texture());
+    glBindImageTexture(0, texture, 0, GL_FALSE, layer, GL_WRITE_ONLY, _format);
+    program.set("mode", 1);
+    program.set("region", region);
+    glDispatchCompute((region.z - region.x + tile_size - 1) / tile_size, region.w - region.y, 1);
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
 }
 
-blur_builder::blur_builder(int target_texture, GLuint texture, int format, int width, int height, int fbo) {
-    init(target_texture, texture, format, width, height, fbo);
+blur_builder::blur_builder(render_target_pool &targets, int target_texture, GLuint texture, int format, int width, int height, int fbo) {
+    init(targets, target_texture, texture, format, width, height, fbo);
 }
@@ -1,29 +1,70 @@
 #pragma once
 
+#include <array>
+#include <optional>
+
+#include <glm/vec4.hpp>
+
+#include "engine/gl_handle.hpp"
+#include "engine/render_target_pool.hpp"
+
 #include "shader_program.hpp"
 
 class blur_builder {
 public:
 
+    // largest supported blur half-width
+    static constexpr int max_N = 15;
+
     blur_builder() = default;
 
-    blur_builder(int target_texture, GLuint texture, int format, int width, int height, int fbo = -1);
+    // the intermediate texture of the two passes is leased from targets for each blur
+    blur_builder(render_target_pool &targets, int target_texture, GLuint texture, int format, int width, int height, int fbo = -1);
 
-    void init(int target_texture, GLuint texture, int format, int width, int height, int fbo = -1);
+    void init(render_target_pool &targets, int target_texture, GLuint texture, int format, int width, int height, int fbo = -1);
 
-    void do_blur(int N = 7, float radius = 5.0);
+    // the intermediate texture of the new size is leased by the next blur,
+    // the output must be resized by the caller
+    void resize(int width, int height);
+
+    // fbo overrides the framebuffer the result is written to,
+    // region (x0, y0, x1, y1) limits the written pixels
+    void do_blur(int N = 7, float radius = 5.0, int fbo = -1, const std::optional<glm::ivec4>& region = std::nullopt);
+
+    // separable passes in a compute shader with a shared memory tile,
+    // enabled when compute shaders and image stores are available
+    bool use_compute = false;
 
 private:
-    GLuint _vao = 0;
-    GLuint _fbo_x = 0;
+
+    void update_weights(int N, float radius);
+
+    void do_blur_fragment(int N, GLuint fbo, const render_target_pool::lease& tmp, const std::optional<glm::ivec4>& region);
+
+    void do_blur_compute(int N, GLuint fbo, const render_target_pool::lease& tmp, const glm::ivec4& region);
+
+    render_target_pool *_targets = nullptr;
+    gl_vertex_array _vao;
+    // output framebuffer, _own_fbo unless the caller passed one
     GLuint _fbo_y = 0;
+    gl_framebuffer _own_fbo;
     GLuint _texture = 0;
-    GLuint _tmp_texture = 0;
     int _target_texture = 0;
+    int _format = 0;
     int _width = 0;
     int _height = 0;
     shader_program _program;
+    shader_program _compute_program;
+    // selects the layout qualifier of the output image, see get_image_variant
+    int _image_variant = 0;
 
-};
-
+    int _N = -1;
+    float _radius = 0.f;
+    // per texel weights for the compute shader
+    std::array<float, max_N + 1> _weights{};
+    // pairs of texels folded into one linear sample for the fragment shader
+    int _taps = 0;
+    std::array<float, max_N + 1> _tap_weights{};
+    std::array<float, max_N + 1> _tap_offsets{};
 
+};
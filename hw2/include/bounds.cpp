@@ -0,0 +1,101 @@
+#include "bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <glm/common.hpp>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define BOUNDS_USE_SSE
+#endif
+
+std::pair<glm::vec3, glm::vec3> empty_bbox() {
+    return {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+}
+
+std::pair<glm::vec3, glm::vec3> compute_bbox(std::span<const vertex> vertices) {
+#ifdef BOUNDS_USE_SSE
+    // the fourth lane reads normal.x and is dropped
+    static_assert(offsetof(vertex, normal) == offsetof(vertex, position) + 3 * sizeof(float));
+    __m128 min0 = _mm_set1_ps(INFINITY);
+    __m128 max0 = _mm_set1_ps(-INFINITY);
+    __m128 min1 = min0;
+    __m128 max1 = max0;
+
+    std::size_t i = 0;
+    for (; i + 1 < vertices.size(); i += 2) {
+        __m128 p0 = _mm_loadu_ps(&vertices[i].position.x);
+        __m128 p1 = _mm_loadu_ps(&vertices[i + 1].position.x);
+        min0 = _mm_min_ps(min0, p0);
+        max0 = _mm_max_ps(max0, p0);
+        min1 = _mm_min_ps(min1, p1);
+        max1 = _mm_max_ps(max1, p1);
+    }
+    if (i < vertices.size()) {
+        __m128 p = _mm_loadu_ps(&vertices[i].position.x);
+        min0 = _mm_min_ps(min0, p);
+        max0 = _mm_max_ps(max0, p);
+    }
+
+    alignas(16) float result_min[4];
+    alignas(16) float result_max[4];
+    _mm_store_ps(result_min, _mm_min_ps(min0, min1));
+    _mm_store_ps(result_max, _mm_max_ps(max0, max1));
+    return {
+        glm::vec3(result_min[0], result_min[1], result_min[2]),
+        glm::vec3(result_max[0], result_max[1], result_max[2])
+    };
+#else
+    auto result = empty_bbox();
+    for (auto& v : vertices) {
+        result.first = glm::min(result.first, v.position);
+        result.second = glm::max(result.second, v.position);
+    }
+    return result;
+#endif
+}
+
+std::pair<glm::vec3, glm::vec3> transform_bbox(const std::pair<glm::vec3, glm::vec3>& bbox, const glm::mat4& transform) {
+    if (bbox.first.x > bbox.second.x) {
+        return bbox;
+    }
+
+    // center and extent instead of 8 corners, same result for affine transforms
+    glm::vec3 center = 0.5f * (bbox.first + bbox.second);
+    glm::vec3 extent = 0.5f * (bbox.second - bbox.first);
+
+    glm::vec3 new_center = transform * glm::vec4(center, 1.f);
+    glm::vec3 new_extent(0.f);
+    for (int i = 0; i < 3; i++) {
+        new_extent += glm::abs(glm::vec3(transform[i])) * extent[i];
+    }
+    return {new_center - new_extent, new_center + new_extent};
+}
+
+std::pair<glm::vec3, glm::vec3> merge_bbox(const std::pair<glm::vec3, glm::vec3>& a, const std::pair<glm::vec3, glm::vec3>& b) {
+    return {glm::min(a.first, b.first), glm::max(a.second, b.second)};
+}
+
+void parallel_for(std::size_t count, const std::function<void(std::size_t)>& func) {
+    std::size_t thread_number = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    if (thread_number <= 1) {
+        for (std::size_t i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    std::vector<std::jthread> threads;
+    threads.reserve(thread_number);
+    for (std::size_t t = 0; t < thread_number; t++) {
+        threads.emplace_back([&func, t, count, thread_number]() {
+            for (std::size_t i = count * t / thread_number; i < count * (t + 1) / thread_number; i++) {
+                func(i);
+            }
+        });
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <utility>
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "utils.hpp"
+
+// min = +inf, max = -inf, neutral for merge_bbox
+std::pair<glm::vec3, glm::vec3> empty_bbox();
+
+// bounding box of vertex positions, SSE min/max reduction where available
+std::pair<glm::vec3, glm::vec3> compute_bbox(std::span<const vertex> vertices);
+
+// bounding box of the 8 transformed corners
+std::pair<glm::vec3, glm::vec3> transform_bbox(const std::pair<glm::vec3, glm::vec3>& bbox, const glm::mat4& transform);
+
+std::pair<glm::vec3, glm::vec3> merge_bbox(const std::pair<glm::vec3, glm::vec3>& a, const std::pair<glm::vec3, glm::vec3>& b);
+
+// calls func(i) for i in [0, count) split into contiguous ranges over hardware threads
+void parallel_for(std::size_t count, const std::function<void(std::size_t)>& func);
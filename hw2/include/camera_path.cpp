@@ -0,0 +1,131 @@
+#include "camera_path.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <glm/common.hpp>
+
+namespace {
+
+// magic, version and key count, then 37 bytes per key in native byte order
+constexpr char magic[4] = {'H', 'W', '2', 'C'};
+constexpr std::uint32_t version = 1;
+
+template <typename T>
+void write_value(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+void read_value(std::ifstream& in, T& value) {
+    in.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+}
+
+glm::mat4 camera_path::key::get_transform() const {
+    glm::mat4 transform = glm::mat4_cast(rotation);
+    transform[3] = glm::vec4(position, 1.f);
+    return transform;
+}
+
+camera_path::camera_path(const std::string &file) {
+    load(file);
+}
+
+void camera_path::load(const std::string &file) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Can't open camera path " + file);
+    }
+    char file_magic[4];
+    std::uint32_t file_version = 0;
+    std::uint32_t count = 0;
+    in.read(file_magic, sizeof(file_magic));
+    read_value(in, file_version);
+    read_value(in, count);
+    if (!in || std::memcmp(file_magic, magic, sizeof(magic)) != 0 || file_version != version) {
+        throw std::runtime_error(file + " is not a camera path of this version");
+    }
+
+    _keys.resize(count);
+    for (auto& k : _keys) {
+        std::uint8_t flags = 0;
+        read_value(in, k.time);
+        read_value(in, k.position);
+        read_value(in, k.rotation);
+        read_value(in, k.helmet_scale);
+        read_value(in, flags);
+        k.helmet_follow = (flags & 1) != 0;
+    }
+    if (!in) {
+        throw std::runtime_error("Camera path " + file + " is truncated");
+    }
+}
+
+void camera_path::save(const std::string &file) const {
+    std::ofstream out(file, std::ios::binary);
+    out.write(magic, sizeof(magic));
+    write_value(out, version);
+    write_value(out, (std::uint32_t) _keys.size());
+    for (auto& k : _keys) {
+        write_value(out, k.time);
+        write_value(out, k.position);
+        write_value(out, k.rotation);
+        write_value(out, k.helmet_scale);
+        write_value(out, (std::uint8_t) (k.helmet_follow ? 1 : 0));
+    }
+    if (!out) {
+        throw std::runtime_error("Can't write camera path " + file);
+    }
+}
+
+void camera_path::add(float time, const glm::mat4 &camera, float helmet_scale, bool helmet_follow) {
+    key k;
+    k.time = time;
+    k.position = camera[3];
+    k.rotation = glm::quat_cast(glm::mat3(camera));
+    k.helmet_scale = helmet_scale;
+    k.helmet_follow = helmet_follow;
+    _keys.push_back(k);
+}
+
+bool camera_path::empty() const {
+    return _keys.empty();
+}
+
+float camera_path::get_start_time() const {
+    return _keys.empty() ? 0.f : _keys.front().time;
+}
+
+float camera_path::get_end_time() const {
+    return _keys.empty() ? 0.f : _keys.back().time;
+}
+
+camera_path::key camera_path::sample(float time) const {
+    if (_keys.empty()) {
+        return {};
+    }
+    auto next = std::upper_bound(_keys.begin(), _keys.end(), time, [](float t, const key& k) {
+        return t < k.time;
+    });
+    if (next == _keys.begin()) {
+        return _keys.front();
+    }
+    if (next == _keys.end()) {
+        return _keys.back();
+    }
+
+    const key& a = *(next - 1);
+    const key& b = *next;
+    float t = (time - a.time) / (b.time - a.time);
+    key result = a;
+    result.time = time;
+    result.position = glm::mix(a.position, b.position, t);
+    result.rotation = glm::slerp(a.rotation, b.rotation, t);
+    result.helmet_scale = glm::mix(a.helmet_scale, b.helmet_scale, t);
+    return result;
+}
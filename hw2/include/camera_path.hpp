@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Camera and view toggles of a live session, recorded once per frame and
+// replayed at any frame rate by interpolating between the recorded frames.
+class camera_path {
+public:
+
+    struct key {
+        // scene time, also moves the directional light
+        float time = 0.f;
+        glm::vec3 position{0.f};
+        glm::quat rotation{1.f, 0.f, 0.f, 0.f};
+        float helmet_scale = 1.f;
+        bool helmet_follow = false;
+
+        glm::mat4 get_transform() const;
+    };
+
+    camera_path() = default;
+
+    // reads a file written by save
+    explicit camera_path(const std::string& file);
+
+    void load(const std::string& file);
+
+    void save(const std::string& file) const;
+
+    // camera is the camera to world transform, times must not decrease
+    void add(float time, const glm::mat4& camera, float helmet_scale, bool helmet_follow);
+
+    bool empty() const;
+
+    float get_start_time() const;
+    float get_end_time() const;
+
+    // interpolated camera at time, toggles of the last frame before it, clamped to the recorded range
+    key sample(float time) const;
+
+private:
+
+    std::vector<key> _keys;
+
+};
@@ -1,6 +1,7 @@
 #include "cubemap_builder.hpp"
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
+#include <array>
 #include <stdexcept>
 
 glm::mat4 get_camera_view(glm::vec3 position, int index) {
@@ -31,22 +32,68 @@ glm::mat4 get_camera_view(glm::vec3 position, int index) {
 }
 
 
+int cubemap_builder::schedule(glm::vec3 position, float screen_size) {
+    int resolution = min_resolution;
+    while (resolution < screen_size && resolution < _max_resolution) {
+        resolution *= 2;
+    }
+
+    // a level of hysteresis so the probe doesn't flip between sizes
+    bool full = !_probe_position.has_value();
+    if (resolution > _resolution || 2 * resolution < _resolution) {
+        allocate(resolution);
+        full = true;
+    }
+
+    if (full) {
+        _probe_position = position;
+        _dirty_faces = 0;
+        return all_faces;
+    }
+
+    if (glm::distance(position, _probe_position.value()) > move_threshold) {
+        _probe_position = position;
+        _dirty_faces = all_faces;
+    }
+
+    int face_mask = 0;
+    for (int i = 0, count = 0; i < 6 && count < faces_per_frame; i++) {
+        int face = (_next_face + i) % 6;
+        if (_dirty_faces & (1 << face)) {
+            face_mask |= 1 << face;
+            count++;
+            _next_face = (face + 1) % 6;
+        }
+    }
+    _dirty_faces &= ~face_mask;
+    return face_mask;
+}
+
+void cubemap_builder::invalidate() {
+    _dirty_faces = all_faces;
+}
+
 void cubemap_builder::draw(
     glm::vec3 position,
     const std::vector<scene_storage *> &scenes,
     shader_program &program,
-    float near, float far
+    uniform_buffer<camera_uniforms> &camera,
+    float near, float far,
+    int face_mask
 ) {
     glViewport(0, 0, _resolution, _resolution);
-    glm::mat4 projection = glm::perspective(glm::radians(90.f), 1.f, near, far);
-    program.bind();
-    glUniformMatrix4fv(program["projection"], 1, GL_FALSE, reinterpret_cast<float *>(&projection));
+    camera_uniforms camera_data{};
+    camera_data.projection = glm::perspective(glm::radians(90.f), 1.f, near, far);
+    camera_data.camera_position = position;
 
     for (int i = 0; i < 6; i++) {
+        if ((face_mask & (1 << i)) == 0) {
+            continue;
+        }
         program.bind();
 
-        glm::mat4 view = get_camera_view(position, i);
-        glUniformMatrix4fv(program["view"], 1, GL_FALSE, reinterpret_cast<float *>(&view));
+        camera_data.view = get_camera_view(position, i);
+        camera.update(camera_data);
         if (_with_blur) {
             glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _tmp_fbo);
         } else {
@@ -77,57 +124,169 @@ void cubemap_builder::draw(
     }
 }
 
-void cubemap_builder::init(int resolution, bool with_blur) {
-    _resolution = resolution;
-    _with_blur = with_blur;
+void cubemap_builder::draw_layered(
+    glm::vec3 position,
+    const std::vector<scene_storage *> &scenes,
+    shader_program &program,
+    uniform_buffer<camera_uniforms> &camera,
+    float near, float far,
+    int face_mask
+) {
+    if (face_mask == 0) {
+        return;
+    }
+
+    glViewport(0, 0, _resolution, _resolution);
+    camera_uniforms camera_data{};
+    camera_data.projection = glm::perspective(glm::radians(90.f), 1.f, near, far);
+    camera_data.view = get_camera_view(position, 0);
+    camera_data.camera_position = position;
+    camera.update(camera_data);
+
+    std::array<glm::mat4, 6> face_transforms;
+    for (int i = 0; i < 6; i++) {
+        face_transforms[i] = camera_data.projection * get_camera_view(position, i);
+    }
+
+    GLuint color = _with_blur ? _layered_texture : cubemap;
+    if (face_mask == all_faces) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _layered_fbo);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    } else {
+        // layered clear would wipe faces that are kept this frame
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _face_fbo);
+        for (int i = 0; i < 6; i++) {
+            if (face_mask & (1 << i)) {
+                glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, color, 0);
+                glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                       GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, _layered_depth, 0);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            }
+        }
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _layered_fbo);
+    }
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+
+    program.bind();
+    for (auto scene : scenes) {
+        scene->draw_objects_layered(program, face_transforms, true, true, face_mask);
+    }
+
+    if (_with_blur) {
+        glCullFace(GL_BACK);
+        for (int i = 0; i < 6; i++) {
+            if ((face_mask & (1 << i)) == 0) {
+                continue;
+            }
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, _face_fbo);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, _layered_texture, 0);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _tmp_fbo);
+            glBlitFramebuffer(0, 0, _resolution, _resolution, 0, 0, _resolution, _resolution,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap, 0);
+            _blur.do_blur(1, 2.0);
+        }
+    }
+}
 
-    glGenTextures(1, &cubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+gl_texture create_cubemap_texture() {
+    gl_texture result = gl_texture::create();
+    glBindTexture(GL_TEXTURE_CUBE_MAP, result);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return result;
+}
 
+void allocate_cubemap_texture(GLuint texture, int resolution, GLenum internal_format, GLenum format, GLenum type) {
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
     for (int i = 0; i < 6; i++) {
         glTexImage2D(
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-            0, GL_RGB, _resolution, _resolution, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr
+            0, internal_format, resolution, resolution, 0, format, type, nullptr
         );
     }
+}
+
+void cubemap_builder::allocate(int resolution) {
+    _resolution = resolution;
+
+    allocate_cubemap_texture(cubemap, _resolution, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    allocate_cubemap_texture(_layered_depth, _resolution, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT);
 
-    glGenRenderbuffers(1, &_rbo);
     glBindRenderbuffer(GL_RENDERBUFFER, _rbo);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _resolution, _resolution);
 
-    glGenFramebuffers(1, &_fbo);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
-    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _rbo);
+    if (_with_blur) {
+        allocate_cubemap_texture(_layered_texture, _resolution, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
 
-    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        throw std::runtime_error("Incomplete framebuffer!");
+        glBindTexture(GL_TEXTURE_2D, _tmp_texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _resolution, _resolution, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+        _blur.resize(_resolution, _resolution);
+    }
+}
+
+void cubemap_builder::init(render_target_pool &targets, int resolution, bool with_blur) {
+    _max_resolution = resolution;
+    _with_blur = with_blur;
+
+    cubemap = create_cubemap_texture();
+    // layered attachments can't be renderbuffers
+    _layered_depth = create_cubemap_texture();
+    _rbo = gl_renderbuffer::create();
+    _fbo = gl_framebuffer::create();
+    _face_fbo = gl_framebuffer::create();
+    _layered_fbo = gl_framebuffer::create();
 
     if (_with_blur) {
-        glGenTextures(1, &_tmp_texture);
+        _layered_texture = create_cubemap_texture();
+
+        _tmp_texture = gl_texture::create();
         glBindTexture(GL_TEXTURE_2D, _tmp_texture);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _resolution, _resolution, 0, GL_RGBA, GL_FLOAT, nullptr);
 
-        glGenFramebuffers(1, &_tmp_fbo);
+        _blur.init(targets, 7, _tmp_texture, GL_RGBA8, resolution, resolution, _fbo);
+    }
+
+    allocate(resolution);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _rbo);
+
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete framebuffer!");
+
+    if (_with_blur) {
+        _tmp_fbo = gl_framebuffer::create();
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _tmp_fbo);
         glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _rbo);
         glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _tmp_texture, 0);
 
         if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
             throw std::runtime_error("Incomplete framebuffer!");
-
-        _blur.init(7, _tmp_texture, GL_RGBA, _resolution, _resolution, _fbo);
     }
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _layered_fbo);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _with_blur ? _layered_texture : cubemap, 0);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, _layered_depth, 0);
+
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete framebuffer!");
 }
 
-cubemap_builder::cubemap_builder(int resolution, bool with_blur) {
-    init(resolution, with_blur);
+cubemap_builder::cubemap_builder(render_target_pool &targets, int resolution, bool with_blur) {
+    init(targets, resolution, with_blur);
 }
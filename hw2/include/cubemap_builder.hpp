@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include <GL/glew.h>
@@ -7,42 +8,86 @@
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 
+#include "engine/gl_handle.hpp"
+#include "engine/render_target_pool.hpp"
+
 #include "scene_storage.hpp"
 #include "shader_program.hpp"
 #include "blur_builder.hpp"
+#include "uniform_buffer.hpp"
+#include "frame_uniforms.hpp"
 
 class cubemap_builder {
 public:
 
+    static constexpr int all_faces = 0b111111;
+
     cubemap_builder() = default;
 
-    void init(int resolution, bool with_blur = false);
+    // targets lends the intermediate texture of the blur
+    void init(render_target_pool &targets, int resolution, bool with_blur = false);
+
+    cubemap_builder(render_target_pool &targets, int resolution, bool with_blur = false);
+
+    // picks faces to redraw this frame round-robin and adapts the resolution
+    // to the probe size on screen in pixels, returns 0 if the probe is up to date
+    int schedule(glm::vec3 position, float screen_size);
 
-    explicit cubemap_builder(int resolution, bool with_blur = false);
+    // marks all faces outdated, they are redrawn within the faces_per_frame budget
+    void invalidate();
 
     void draw(
         glm::vec3 position,
         const std::vector<scene_storage *> &scenes,
         shader_program &program,
-        float near, float far
+        uniform_buffer<camera_uniforms> &camera,
+        float near, float far,
+        int face_mask = all_faces
     );
 
+    // draws the scenes once into all faces, program must have the layered geometry shader
+    void draw_layered(
+        glm::vec3 position,
+        const std::vector<scene_storage *> &scenes,
+        shader_program &program,
+        uniform_buffer<camera_uniforms> &camera,
+        float near, float far,
+        int face_mask = all_faces
+    );
 
 private:
 
-    GLuint _fbo = 0;
-    GLuint _rbo = 0;
+    // (re)specifies all textures with the given face size
+    void allocate(int resolution);
+
+    gl_framebuffer _fbo;
+    gl_renderbuffer _rbo;
     int _resolution = 0;
+    int _max_resolution = 0;
     bool _with_blur = false;
 
     blur_builder _blur;
-    GLuint _tmp_texture = 0;
-    GLuint _tmp_fbo = 0;
+    gl_texture _tmp_texture;
+    gl_framebuffer _tmp_fbo;
 
-public:
+    gl_framebuffer _layered_fbo;
+    gl_texture _layered_depth;
+    // layered render target when blurring, faces are copied to _tmp_texture one by one
+    gl_texture _layered_texture;
+    // single face of the layered target
+    gl_framebuffer _face_fbo;
 
-    GLuint cubemap = 0;
+    std::optional<glm::vec3> _probe_position;
+    int _dirty_faces = all_faces;
+    int _next_face = 0;
 
-};
+public:
+
+    gl_texture cubemap;
 
+    int faces_per_frame = 2;
+    // probe movement after which all faces are outdated
+    float move_threshold = 0.1f;
+    int min_resolution = 16;
 
+};
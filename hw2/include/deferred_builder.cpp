@@ -0,0 +1,232 @@
+#include "deferred_builder.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/matrix.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "frame_uniforms.hpp"
+#include "object_vertex_shader.h"
+#include "gbuffer_fragment_shader.h"
+#include "blur_vertex_shader.h"
+#include "deferred_directional_fragment_shader.h"
+#include "deferred_point_vertex_shader.h"
+#include "deferred_point_fragment_shader.h"
+#include "deferred_resolve_fragment_shader.h"
+
+namespace {
+
+const int sphere_rings = 8;
+const int sphere_segments = 12;
+
+}
+
+deferred_builder::deferred_builder(int first_texture, int width, int height) {
+    init(first_texture, width, height);
+}
+
+void deferred_builder::init(int first_texture, int width, int height) {
+    _first_texture = first_texture;
+
+    geometry_program.init(object_vertex_shader_source, gbuffer_fragment_shader_source);
+    geometry_program.enable_variants();
+    directional_program.init(blur_vertex_shader_source, deferred_directional_fragment_shader_source);
+    point_program.init(deferred_point_vertex_shader_source, deferred_point_fragment_shader_source);
+    _resolve_program.init(blur_vertex_shader_source, deferred_resolve_fragment_shader_source);
+    for (shader_program *program : {&geometry_program, &directional_program, &point_program}) {
+        program->bind_uniform_block("camera_data", camera_uniforms::binding);
+        program->bind_uniform_block("light_data", light_uniforms::binding);
+    }
+
+    glActiveTexture(GL_TEXTURE0 + first_texture);
+    for (gl_texture *texture : {&_albedo_texture, &_normal_texture, &_specular_texture, &_depth_texture, &_light_texture}) {
+        *texture = gl_texture::create();
+        glBindTexture(GL_TEXTURE_2D, *texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    _light_depth = gl_renderbuffer::create();
+
+    resize(width, height);
+
+    _gbuffer_fbo = gl_framebuffer::create();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _gbuffer_fbo);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _albedo_texture, 0);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, _normal_texture, 0);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, _specular_texture, 0);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, _depth_texture, 0);
+    GLenum buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    glDrawBuffers(3, buffers);
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete framebuffer!");
+
+    // light volumes are tested against a copy of the scene depth, attaching _depth_texture
+    // while the passes sample it would be a feedback loop
+    _light_fbo = gl_framebuffer::create();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _light_fbo);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _light_texture, 0);
+    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _light_depth);
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete framebuffer!");
+
+    _fullscreen_vao = gl_vertex_array::create();
+
+    // the polygon touches the unit sphere at its vertices, enlarged so its faces do too
+    float scale = 1.f / (std::cos(glm::pi<float>() / (2.f * sphere_rings))
+        * std::cos(glm::pi<float>() / sphere_segments));
+    std::vector<glm::vec3> vertices;
+    for (int ring = 0; ring <= sphere_rings; ring++) {
+        float theta = glm::pi<float>() * (float) ring / sphere_rings;
+        for (int segment = 0; segment < sphere_segments; segment++) {
+            float phi = 2.f * glm::pi<float>() * (float) segment / sphere_segments;
+            vertices.emplace_back(
+                scale * std::sin(theta) * std::cos(phi),
+                scale * std::cos(theta),
+                scale * std::sin(theta) * std::sin(phi)
+            );
+        }
+    }
+    std::vector<GLuint> indices;
+    for (int ring = 0; ring < sphere_rings; ring++) {
+        for (int segment = 0; segment < sphere_segments; segment++) {
+            GLuint i0 = ring * sphere_segments + segment;
+            GLuint i1 = ring * sphere_segments + (segment + 1) % sphere_segments;
+            GLuint i2 = i0 + sphere_segments;
+            GLuint i3 = i1 + sphere_segments;
+            // counter-clockwise from outside
+            indices.insert(indices.end(), {i0, i1, i2, i1, i3, i2});
+        }
+    }
+    _sphere_index_number = (GLsizei) indices.size();
+
+    _sphere_vao = gl_vertex_array::create();
+    glBindVertexArray(_sphere_vao);
+    _sphere_vbo = gl_buffer::create();
+    glBindBuffer(GL_ARRAY_BUFFER, _sphere_vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STATIC_DRAW);
+    _sphere_ebo = gl_buffer::create();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphere_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+}
+
+void deferred_builder::resize(int width, int height) {
+    _width = width;
+    _height = height;
+
+    glActiveTexture(GL_TEXTURE0 + _first_texture);
+    glBindTexture(GL_TEXTURE_2D, _albedo_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, _normal_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16, width, height, 0, GL_RGBA, GL_UNSIGNED_SHORT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, _specular_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, _light_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    // same format as the default framebuffer so depth can be blitted
+    glBindTexture(GL_TEXTURE_2D, _depth_texture);
+    glTexImage2D(
+        GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0,
+        GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr
+    );
+    glBindRenderbuffer(GL_RENDERBUFFER, _light_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+}
+
+void deferred_builder::begin() {
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _gbuffer_fbo);
+    glViewport(0, 0, _width, _height);
+
+    const float zero[] = {0.f, 0.f, 0.f, 0.f};
+    for (int i = 0; i < 3; i++) {
+        glClearBufferfv(GL_COLOR, i, zero);
+    }
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    geometry_program.bind();
+}
+
+void deferred_builder::bind_gbuffer(const shader_program &program) const {
+    const char *names[] = {"gbuffer_albedo", "gbuffer_normal", "gbuffer_specular", "gbuffer_depth"};
+    GLuint textures[] = {_albedo_texture, _normal_texture, _specular_texture, _depth_texture};
+    for (int i = 0; i < 4; i++) {
+        glActiveTexture(GL_TEXTURE0 + _first_texture + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        program.set(uniform_name(names[i]), _first_texture + i);
+    }
+}
+
+void deferred_builder::end(
+    const glm::mat4 &view,
+    const glm::mat4 &projection,
+    int point_light_number,
+    float max_light_distance,
+    GLuint fbo
+) {
+    glm::mat4 inverse_view_projection = glm::inverse(projection * view);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _gbuffer_fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _light_fbo);
+    glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    // the background keeps stale values, the resolve pass skips it
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    directional_program.bind();
+    bind_gbuffer(directional_program);
+    directional_program.set("inverse_view_projection", inverse_view_projection);
+    glBindVertexArray(_fullscreen_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    // back faces behind the surface: covers the pixels inside the volume
+    // with the camera inside it too, clamped depth keeps the far side of huge volumes
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_GEQUAL);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glEnable(GL_DEPTH_CLAMP);
+
+    point_program.bind();
+    bind_gbuffer(point_program);
+    point_program.set("inverse_view_projection", inverse_view_projection);
+    point_program.set("viewport_size", glm::vec2(_width, _height));
+    point_program.set("max_light_distance", max_light_distance);
+    glBindVertexArray(_sphere_vao);
+    glDrawElementsInstanced(GL_TRIANGLES, _sphere_index_number, GL_UNSIGNED_INT, nullptr, point_light_number);
+
+    glDisable(GL_DEPTH_CLAMP);
+    glCullFace(GL_BACK);
+    glDepthFunc(GL_LEQUAL);
+    glDisable(GL_BLEND);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    glDisable(GL_DEPTH_TEST);
+
+    _resolve_program.bind();
+    glActiveTexture(GL_TEXTURE0 + _first_texture);
+    glBindTexture(GL_TEXTURE_2D, _light_texture);
+    _resolve_program.set("light_accumulation", _first_texture);
+    glActiveTexture(GL_TEXTURE0 + _first_texture + 3);
+    glBindTexture(GL_TEXTURE_2D, _depth_texture);
+    _resolve_program.set("gbuffer_depth", _first_texture + 3);
+    glBindVertexArray(_fullscreen_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _gbuffer_fbo);
+    glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+}
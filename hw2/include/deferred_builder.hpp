@@ -0,0 +1,70 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/mat4x4.hpp>
+
+#include "engine/gl_handle.hpp"
+#include "shader_program.hpp"
+
+// Deferred shading: opaque objects write their material into a G-buffer, the sun
+// is applied in one fullscreen pass and every point light shades only the pixels
+// inside its radius, drawn as an instanced sphere. The HDR sum is tone mapped
+// into the target framebuffer together with a copy of the depth.
+class deferred_builder {
+public:
+
+    deferred_builder() = default;
+
+    deferred_builder(int first_texture, int width, int height);
+
+    void init(int first_texture, int width, int height);
+
+    void resize(int width, int height);
+
+    // binds and clears the G-buffer, objects are drawn with geometry_program
+    void begin();
+
+    // lights the G-buffer into fbo, programs expect the same shadow maps
+    // and point light buffers as the forward object program
+    void end(
+        const glm::mat4& view,
+        const glm::mat4& projection,
+        int point_light_number,
+        float max_light_distance,
+        GLuint fbo = 0
+    );
+
+    shader_program geometry_program;
+    shader_program directional_program;
+    shader_program point_program;
+
+private:
+
+    void bind_gbuffer(const shader_program& program) const;
+
+    gl_framebuffer _gbuffer_fbo;
+    gl_framebuffer _light_fbo;
+    // GL_RGBA8 albedo, GL_RGBA16 normals, GL_RGBA8 specular, GL_DEPTH24_STENCIL8
+    gl_texture _albedo_texture;
+    gl_texture _normal_texture;
+    gl_texture _specular_texture;
+    gl_texture _depth_texture;
+    // GL_RGBA16F sum of all lights
+    gl_texture _light_texture;
+    // copy of the G-buffer depth for testing light volumes, the texture is sampled meanwhile
+    gl_renderbuffer _light_depth;
+
+    gl_vertex_array _fullscreen_vao;
+    gl_vertex_array _sphere_vao;
+    gl_buffer _sphere_vbo;
+    gl_buffer _sphere_ebo;
+    GLsizei _sphere_index_number = 0;
+
+    shader_program _resolve_program;
+
+    int _first_texture = 0;
+    int _width = 0;
+    int _height = 0;
+
+};
@@ -1,7 +1,10 @@
 #include "direction_light_object.hpp"
 
+#include <cmath>
 #include <vector>
 
+#include <glm/ext/matrix_clip_space.hpp>
+
 direction_light_object::direction_light_object(const glm::vec3 &direction, const glm::vec3 &light) :
     direction(direction), light(light) {}
 
@@ -18,9 +21,9 @@ glm::mat4 direction_light_object::get_transform(const std::pair<glm::vec3, glm::
             for (auto z_v: {bbox.first.z, bbox.second.z}) {
                 glm::vec3 v(x_v, y_v, z_v);
                 v -= bbox_center;
-                shadow_scale_x = std::max(shadow_scale_x, abs(glm::dot(v, light_x)));
-                shadow_scale_y = std::max(shadow_scale_y, abs(glm::dot(v, light_y)));
-                shadow_scale_z = std::max(shadow_scale_z, abs(glm::dot(v, light_z)));
+                shadow_scale_x = std::max(shadow_scale_x, std::abs(glm::dot(v, light_x)));
+                shadow_scale_y = std::max(shadow_scale_y, std::abs(glm::dot(v, light_y)));
+                shadow_scale_z = std::max(shadow_scale_z, std::abs(glm::dot(v, light_z)));
             }
         }
     }
@@ -37,3 +40,66 @@ glm::mat4 direction_light_object::get_transform(const std::pair<glm::vec3, glm::
 
     return transform;
 }
+
+glm::mat4 direction_light_object::get_cascade_transform(
+    const std::pair<glm::vec3, glm::vec3>& bbox,
+    const glm::mat4& view,
+    float fov, float aspect,
+    float near, float far,
+    int resolution
+) const {
+    glm::vec3 light_z = -direction;
+    glm::vec3 light_x = glm::normalize(glm::cross(light_z, {1.f, 0.f, 0.f}));
+    glm::vec3 light_y = glm::cross(light_x, light_z);
+
+    glm::mat4 inverse_view_projection = glm::inverse(glm::perspective(fov, aspect, near, far) * view);
+
+    glm::vec3 corners[8];
+    glm::vec3 center(0.f);
+    int k = 0;
+    for (auto x_v : {-1.f, 1.f}) {
+        for (auto y_v : {-1.f, 1.f}) {
+            for (auto z_v : {-1.f, 1.f}) {
+                glm::vec4 v = inverse_view_projection * glm::vec4(x_v, y_v, z_v, 1.f);
+                corners[k] = glm::vec3(v) / v.w;
+                center += corners[k] / 8.f;
+                k++;
+            }
+        }
+    }
+
+    // bounding sphere keeps the cascade size independent of camera rotation
+    float radius = 0.f;
+    for (auto& corner : corners) {
+        radius = std::max(radius, glm::length(corner - center));
+    }
+    radius = std::ceil(radius * 16.f) / 16.f;
+
+    float texel = 2.f * radius / (float) resolution;
+    float center_x = std::floor(glm::dot(center, light_x) / texel) * texel;
+    float center_y = std::floor(glm::dot(center, light_y) / texel) * texel;
+
+    // depth range covers the whole scene to keep casters outside of the slice
+    float z_min = INFINITY;
+    float z_max = -INFINITY;
+    for (auto x_v: {bbox.first.x, bbox.second.x}) {
+        for (auto y_v: {bbox.first.y, bbox.second.y}) {
+            for (auto z_v: {bbox.first.z, bbox.second.z}) {
+                float z = glm::dot(glm::vec3(x_v, y_v, z_v), light_z);
+                z_min = std::min(z_min, z);
+                z_max = std::max(z_max, z);
+            }
+        }
+    }
+    float center_z = 0.5f * (z_min + z_max);
+    float shadow_scale_z = 0.5f * (z_max - z_min);
+
+    glm::vec3 origin = center_x * light_x + center_y * light_y + center_z * light_z;
+
+    return glm::inverse(glm::mat4(
+        glm::vec4(light_x * radius, 0.f),
+        glm::vec4(light_y * radius, 0.f),
+        glm::vec4(light_z * shadow_scale_z, 0.f),
+        glm::vec4(origin, 1.f)
+    ));
+}
@@ -3,6 +3,8 @@
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 
+#include <utility>
+
 
 class direction_light_object {
 public:
@@ -11,6 +13,16 @@ public:
 
     glm::mat4 get_transform(const std::pair<glm::vec3, glm::vec3>& bbox) const;
 
+    // transform of the shadow cascade covering [near, far] of the camera frustum,
+    // snapped to texels of a resolution x resolution map to avoid shimmering
+    glm::mat4 get_cascade_transform(
+        const std::pair<glm::vec3, glm::vec3>& bbox,
+        const glm::mat4& view,
+        float fov, float aspect,
+        float near, float far,
+        int resolution
+    ) const;
+
 public:
 
     glm::vec3 direction;
@@ -0,0 +1,100 @@
+#include "file_watcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+file_watcher::file_watcher() {
+#ifdef __linux__
+    _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+file_watcher::~file_watcher() {
+#ifdef __linux__
+    if (_fd >= 0) {
+        close(_fd);
+    }
+#endif
+}
+
+void file_watcher::watch(const std::filesystem::path &directory) {
+    std::error_code error;
+#ifdef __linux__
+    if (_fd >= 0) {
+        // editors often save by renaming a temporary file over the original
+        const auto mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+        std::vector<std::filesystem::path> directories = {directory};
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_directory()) {
+                directories.push_back(it->path());
+            }
+        }
+        for (auto &path : directories) {
+            int wd = inotify_add_watch(_fd, path.c_str(), mask);
+            if (wd >= 0) {
+                _directories[wd] = path;
+            }
+        }
+        return;
+    }
+#endif
+    _roots.push_back(directory);
+    scan(nullptr);
+}
+
+std::vector<std::filesystem::path> file_watcher::poll() {
+    std::vector<std::filesystem::path> changed;
+#ifdef __linux__
+    if (_fd >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(_fd, buffer, sizeof(buffer))) > 0) {
+            for (char *ptr = buffer; ptr < buffer + length; ) {
+                auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                if (event->len > 0 && _directories.contains(event->wd)) {
+                    changed.push_back(_directories[event->wd] / event->name);
+                }
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+#endif
+    if (!_roots.empty()) {
+        long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (now - _last_scan_ms >= poll_interval_ms) {
+            _last_scan_ms = now;
+            scan(&changed);
+        }
+    }
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+void file_watcher::scan(std::vector<std::filesystem::path> *changed) {
+    std::error_code error;
+    for (auto &root : _roots) {
+        for (auto it = std::filesystem::recursive_directory_iterator(root, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (!it->is_regular_file(error)) {
+                continue;
+            }
+            auto time = it->last_write_time(error);
+            auto [entry, inserted] = _times.try_emplace(it->path().string(), time);
+            if (!inserted && entry->second != time) {
+                entry->second = time;
+                if (changed != nullptr) {
+                    changed->push_back(it->path());
+                }
+            }
+        }
+    }
+}
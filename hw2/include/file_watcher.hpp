@@ -0,0 +1,38 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files written in watched directories and their subdirectories.
+// Uses inotify on Linux, elsewhere modification times are compared at most once per poll_interval.
+class file_watcher {
+public:
+
+    file_watcher();
+
+    ~file_watcher();
+
+    file_watcher(const file_watcher&) = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+
+    void watch(const std::filesystem::path &directory);
+
+    // files changed since the last call, each listed once; never blocks
+    std::vector<std::filesystem::path> poll();
+
+    int poll_interval_ms = 250;
+
+private:
+
+    int _fd = -1;
+    std::unordered_map<int, std::filesystem::path> _directories;
+
+    std::vector<std::filesystem::path> _roots;
+    std::unordered_map<std::string, std::filesystem::file_time_type> _times;
+    long long _last_scan_ms = 0;
+
+    void scan(std::vector<std::filesystem::path> *changed);
+
+};
@@ -0,0 +1,38 @@
+#include "frame_statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+frame_statistics get_frame_statistics(std::span<const double> times) {
+    frame_statistics result;
+    if (times.empty()) {
+        return result;
+    }
+    std::vector<double> sorted(times.begin(), times.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    // nearest rank
+    auto percentile = [&sorted](double p) {
+        auto rank = (std::size_t) std::ceil(p * (double) sorted.size());
+        return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+    };
+
+    result.frames = (int) sorted.size();
+    result.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / (double) sorted.size();
+    result.p50 = percentile(0.5);
+    result.p95 = percentile(0.95);
+    result.p99 = percentile(0.99);
+    result.worst = sorted.back();
+    return result;
+}
+
+std::ostream &operator<<(std::ostream &out, const frame_statistics &statistics) {
+    return out << statistics.frames << " frames, ms: mean " << statistics.mean
+               << " p50 " << statistics.p50
+               << " p95 " << statistics.p95
+               << " p99 " << statistics.p99
+               << " worst " << statistics.worst;
+}
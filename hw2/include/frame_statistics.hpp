@@ -0,0 +1,18 @@
+#pragma once
+
+#include <iosfwd>
+#include <span>
+
+// frame times in milliseconds summarized for comparing builds
+struct frame_statistics {
+    int frames = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double worst = 0.0;
+};
+
+frame_statistics get_frame_statistics(std::span<const double> times);
+
+std::ostream& operator<<(std::ostream& out, const frame_statistics& statistics);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+// std140 mirrors of the uniform blocks declared in object shaders
+
+struct camera_uniforms {
+    static constexpr unsigned int binding = 0;
+
+    glm::mat4 view;
+    glm::mat4 projection;
+    alignas(16) glm::vec3 camera_position;
+};
+
+struct light_uniforms {
+    static constexpr unsigned int binding = 1;
+
+    glm::mat4 transform;
+    alignas(16) glm::vec3 ambient;
+    alignas(16) glm::vec3 light_direction;
+    alignas(16) glm::vec3 light_color;
+    alignas(16) glm::mat4 cascade_transforms[4];
+    int cascade_number;
+    int rescaled_moments;
+};
@@ -0,0 +1,171 @@
+#include "light_cluster_builder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+light_cluster_builder::light_cluster_builder(int tiles_x, int tiles_y, int slices, float near, float far, float threshold) {
+    init(tiles_x, tiles_y, slices, near, far, threshold);
+}
+
+void light_cluster_builder::init(int tiles_x, int tiles_y, int slices, float near, float far, float threshold) {
+    _tiles_x = tiles_x;
+    _tiles_y = tiles_y;
+    _slices = slices;
+    _near = near;
+    _far = far;
+    _threshold = threshold;
+
+    _lights_buffer = gl_buffer::create();
+    _clusters_buffer = gl_buffer::create();
+    _indices_buffer = gl_buffer::create();
+
+    _lights_texture = gl_texture::create();
+    _clusters_texture = gl_texture::create();
+    _indices_texture = gl_texture::create();
+
+    build({}, glm::mat4(1.f), glm::mat4(1.f));
+
+    glBindTexture(GL_TEXTURE_BUFFER, _lights_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _lights_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, _clusters_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, _clusters_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, _indices_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, _indices_buffer);
+}
+
+void light_cluster_builder::build(
+    const std::vector<point_light_object>& lights,
+    const glm::mat4& view,
+    const glm::mat4& projection
+) {
+    int cluster_number = _tiles_x * _tiles_y * _slices;
+    float log_ratio = std::log(_far / _near);
+
+    auto get_slice = [&](float depth) {
+        if (depth <= 0.f) {
+            return 0;
+        }
+        int slice = (int) std::floor(std::log(depth / _near) / log_ratio * (float) _slices);
+        return std::clamp(slice, 0, _slices - 1);
+    };
+
+    auto get_tile = [](float ndc, int tiles) {
+        return std::clamp((int) std::floor((ndc * 0.5f + 0.5f) * (float) tiles), 0, tiles - 1);
+    };
+
+    _light_number = (int) lights.size();
+    _light_data.clear();
+    _light_bounds.clear();
+    _index_data.clear();
+    _cluster_data.assign(2 * cluster_number, 0);
+
+    for (auto& light : lights) {
+        float radius = light.get_radius(_threshold);
+
+        _light_data.emplace_back(light.position, radius);
+        _light_data.emplace_back(light.light, 0.f);
+        _light_data.emplace_back(light.attenuation, 0.f);
+
+        glm::vec3 center = view * glm::vec4(light.position, 1.f);
+        float z_min = -center.z - radius;
+        float z_max = -center.z + radius;
+
+        // x0, x1, y0, y1, s0, s1; empty range when x0 > x1
+        int bounds[6] = {1, 0, 0, 0, 0, 0};
+
+        if (radius > 0.f && z_max > 0.f) {
+            bounds[0] = 0;
+            bounds[1] = _tiles_x - 1;
+            bounds[2] = 0;
+            bounds[3] = _tiles_y - 1;
+            bounds[4] = get_slice(z_min);
+            bounds[5] = std::isfinite(z_max) ? get_slice(z_max) : _slices - 1;
+
+            if (std::isfinite(radius) && z_min > 0.f) {
+                glm::vec2 ndc_min(INFINITY);
+                glm::vec2 ndc_max(-INFINITY);
+                for (float dx : {-radius, radius}) {
+                    for (float dy : {-radius, radius}) {
+                        for (float dz : {-radius, radius}) {
+                            glm::vec4 clip = projection * glm::vec4(center + glm::vec3(dx, dy, dz), 1.f);
+                            glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                            ndc_min = glm::min(ndc_min, ndc);
+                            ndc_max = glm::max(ndc_max, ndc);
+                        }
+                    }
+                }
+                if (ndc_max.x < -1.f || ndc_min.x > 1.f || ndc_max.y < -1.f || ndc_min.y > 1.f) {
+                    bounds[0] = 1;
+                    bounds[1] = 0;
+                } else {
+                    bounds[0] = get_tile(ndc_min.x, _tiles_x);
+                    bounds[1] = get_tile(ndc_max.x, _tiles_x);
+                    bounds[2] = get_tile(ndc_min.y, _tiles_y);
+                    bounds[3] = get_tile(ndc_max.y, _tiles_y);
+                }
+            }
+        }
+
+        _light_bounds.insert(_light_bounds.end(), bounds, bounds + 6);
+
+        for (int s = bounds[4]; s <= bounds[5] && bounds[0] <= bounds[1]; s++) {
+            for (int y = bounds[2]; y <= bounds[3]; y++) {
+                for (int x = bounds[0]; x <= bounds[1]; x++) {
+                    _cluster_data[2 * ((s * _tiles_y + y) * _tiles_x + x) + 1]++;
+                }
+            }
+        }
+    }
+
+    GLuint offset = 0;
+    for (int c = 0; c < cluster_number; c++) {
+        _cluster_data[2 * c] = offset;
+        offset += _cluster_data[2 * c + 1];
+        _cluster_data[2 * c + 1] = 0;
+    }
+    _index_data.resize(std::max<GLuint>(offset, 1));
+
+    for (int i = 0; i < _light_number; i++) {
+        const int *bounds = _light_bounds.data() + 6 * i;
+        for (int s = bounds[4]; s <= bounds[5] && bounds[0] <= bounds[1]; s++) {
+            for (int y = bounds[2]; y <= bounds[3]; y++) {
+                for (int x = bounds[0]; x <= bounds[1]; x++) {
+                    int c = (s * _tiles_y + y) * _tiles_x + x;
+                    _index_data[_cluster_data[2 * c] + _cluster_data[2 * c + 1]++] = i;
+                }
+            }
+        }
+    }
+
+    if (_light_data.empty()) {
+        _light_data.emplace_back(0.f);
+    }
+
+    upload(_lights_buffer, _light_data.data(), _light_data.size() * sizeof(_light_data[0]));
+    upload(_clusters_buffer, _cluster_data.data(), _cluster_data.size() * sizeof(_cluster_data[0]));
+    upload(_indices_buffer, _index_data.data(), _index_data.size() * sizeof(_index_data[0]));
+}
+
+void light_cluster_builder::bind(const shader_program &program, int first_texture, bool use_clusters) const {
+    glActiveTexture(GL_TEXTURE0 + first_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, _lights_texture);
+    program.set("point_light_data", first_texture);
+
+    glActiveTexture(GL_TEXTURE0 + first_texture + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, _clusters_texture);
+    program.set("light_cluster_data", first_texture + 1);
+
+    glActiveTexture(GL_TEXTURE0 + first_texture + 2);
+    glBindTexture(GL_TEXTURE_BUFFER, _indices_texture);
+    program.set("light_index_data", first_texture + 2);
+
+    program.set("point_light_number", _light_number);
+    program.set("use_light_clusters", use_clusters);
+    program.set("light_cluster_grid", glm::ivec3(_tiles_x, _tiles_y, _slices));
+    program.set("light_cluster_depth", glm::vec2(_near, _far));
+}
+
+void light_cluster_builder::upload(GLuint buffer, const void *data, std::size_t size) const {
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "engine/gl_handle.hpp"
+#include "shader_program.hpp"
+#include "point_light_object.hpp"
+
+// Assigns point lights to view-space clusters (screen tiles x exponential depth slices)
+// and uploads lights and per-cluster light lists as texture buffers.
+class light_cluster_builder {
+public:
+
+    light_cluster_builder() = default;
+
+    light_cluster_builder(int tiles_x, int tiles_y, int slices, float near, float far, float threshold = 0.02f);
+
+    void init(int tiles_x, int tiles_y, int slices, float near, float far, float threshold = 0.02f);
+
+    void build(const std::vector<point_light_object>& lights, const glm::mat4& view, const glm::mat4& projection);
+
+    // binds light buffers to first_texture .. first_texture + 2, program must be bound
+    void bind(const shader_program& program, int first_texture, bool use_clusters = true) const;
+
+private:
+
+    void upload(GLuint buffer, const void *data, std::size_t size) const;
+
+    int _tiles_x = 0;
+    int _tiles_y = 0;
+    int _slices = 0;
+    float _near = 0.f;
+    float _far = 0.f;
+    float _threshold = 0.f;
+    int _light_number = 0;
+
+    gl_buffer _lights_buffer;
+    gl_texture _lights_texture;
+    gl_buffer _clusters_buffer;
+    gl_texture _clusters_texture;
+    gl_buffer _indices_buffer;
+    gl_texture _indices_texture;
+
+    std::vector<glm::vec4> _light_data;
+    std::vector<GLuint> _cluster_data;
+    std::vector<GLuint> _index_data;
+    std::vector<int> _light_bounds;
+
+};
@@ -1,72 +1,117 @@
 #include "object.hpp"
 
+#include <cmath>
+#include <tuple>
+
+#include <glm/common.hpp>
+
+#include "bounds.hpp"
+
 object::object(std::vector<vertex> vertices, const glm::vec3& specular_color, float specular_power) :
     vertices(std::move(vertices)), _specular_color(specular_color), _specular_power(specular_power) {
-    glGenVertexArrays(1, &_vao);
-    glGenBuffers(1, &_vbo);
+    _vao = gl_vertex_array::create();
+    _vbo = gl_buffer::create();
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(this->vertices[0]), this->vertices.data(), GL_DYNAMIC_COPY);
     init_vao_vertex(_vao);
 }
 
 void object::draw(const shader_program &program, bool use_textures, bool use_shadow_map) {
+    bind(program, use_textures, use_shadow_map);
+    glVertexAttribI1i(3, node);
+
+    if (_indices.has_value()) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+        glDrawElements(GL_TRIANGLES, _indices.value().size(), GL_UNSIGNED_INT, nullptr);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    }
+}
+
+void object::draw_instances(
+    const shader_program &program,
+    std::span<const int> nodes,
+    bool use_textures,
+    bool use_shadow_map
+) {
+    if (nodes.empty()) {
+        return;
+    }
+    bind(program, use_textures, use_shadow_map);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, nodes.size_bytes(), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, nodes.size_bytes(), nodes.data());
+
+    if (_indices.has_value()) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+        glDrawElementsInstanced(GL_TRIANGLES, _indices.value().size(), GL_UNSIGNED_INT, nullptr, nodes.size());
+    } else {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, vertices.size(), nodes.size());
+    }
+}
+
+void object::bind(const shader_program &program, bool use_textures, bool use_shadow_map) {
     glBindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    glUniformMatrix4fv(program["model"], 1, GL_FALSE, reinterpret_cast<float *>(&model));
 
-    int textures_mask = 0;
+    // units are assigned even without a texture, samplers of different types
+    // left at unit 0 make draws with the uber program invalid
+    program.set("albedo_texture", 1);
+    program.set("specular_map", 2);
+    program.set("norm_map", 3);
+    program.set("mask", 4);
+    program.set("env_map", 5);
 
     if (use_textures) {
         if (_albedo_texture.has_value()) {
             glActiveTexture(GL_TEXTURE1);
             glBindTexture(GL_TEXTURE_2D, _albedo_texture.value());
-            glUniform1i(program["albedo_texture"], 1);
-            textures_mask |= (1 << 1);
         }
 
         if (_specular_map.has_value()) {
             glActiveTexture(GL_TEXTURE2);
             glBindTexture(GL_TEXTURE_2D, _specular_map.value());
-            glUniform1i(program["specular_map"], 2);
-            textures_mask |= (1 << 2);
         }
 
         if (_norm_map.has_value()) {
             glActiveTexture(GL_TEXTURE3);
             glBindTexture(GL_TEXTURE_2D, _norm_map.value());
-            glUniform1i(program["norm_map"], 3);
-            textures_mask |= (1 << 3);
         }
     }
 
     if (_mask.has_value()) {
         glActiveTexture(GL_TEXTURE4);
         glBindTexture(GL_TEXTURE_2D, _mask.value());
-        glUniform1i(program["mask"], 4);
-        textures_mask |= (1 << 4);
     }
 
     if (_env_map.has_value()) {
         glActiveTexture(GL_TEXTURE5);
         glBindTexture(GL_TEXTURE_CUBE_MAP, _env_map.value());
-        glUniform1i(program["env_map"], 5);
-        textures_mask |= (1 << 5);
     }
 
-    if (use_shadow_map) {
-        textures_mask |= (1 << 0);
-    }
+    program.set("textures_mask", get_features(use_textures, use_shadow_map));
+    program.set("specular_power", _specular_power);
+    program.set("specular_color", _specular_color);
 
-    glUniform1i(program["textures_mask"], textures_mask);
-    glUniform1f(program["specular_power"], _specular_power);
-    glUniform3fv(program["specular_color"], 1, reinterpret_cast<float *>(&_specular_color));
+    // 0 opaque, 1 alpha tested, 2 blended
+    program.set("alpha_mode", _blended ? 2 : _mask.has_value() ? 1 : 0);
+    program.set("opacity", _opacity);
+}
 
-    if (_indices.has_value()) {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-        glDrawElements(GL_TRIANGLES, _indices.value().size(), GL_UNSIGNED_INT, nullptr);
-    } else {
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+int object::get_features(bool use_textures, bool use_shadow_map) const {
+    int features = 0;
+    if (use_shadow_map) {
+        features |= (1 << 0);
+    }
+    if (use_textures) {
+        features |= _albedo_texture.has_value() ? (1 << 1) : 0;
+        features |= _specular_map.has_value() ? (1 << 2) : 0;
+        features |= _norm_map.has_value() ? (1 << 3) : 0;
     }
+    features |= _mask.has_value() ? (1 << 4) : 0;
+    features |= _env_map.has_value() ? (1 << 5) : 0;
+    return features;
 }
 
 object &object::with_albedo_texture(GLuint albedo_texture) {
@@ -76,7 +121,7 @@ object &object::with_albedo_texture(GLuint albedo_texture) {
 
 object &object::with_indices(std::vector<int> indices) {
     _indices = std::move(indices);
-    glGenBuffers(1, &_ebo);
+    _ebo = gl_buffer::create();
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indices.value().size() * sizeof(_indices.value()[0]),
                  _indices.value().data(), GL_DYNAMIC_COPY);
@@ -98,11 +143,94 @@ object &object::with_mask(GLuint mask) {
     return *this;
 }
 
+object &object::with_instances(std::vector<int> nodes) {
+    _instances = std::move(nodes);
+    if (!_instance_vbo) {
+        _instance_vbo = gl_buffer::create();
+        glBindVertexArray(_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, _instance_vbo);
+        glEnableVertexAttribArray(3);
+        glVertexAttribIPointer(3, 1, GL_INT, sizeof(int), (void *) (0));
+        glVertexAttribDivisor(3, 1);
+    }
+    return *this;
+}
+
+const std::vector<int> &object::get_instances() const {
+    return _instances;
+}
+
 bool object::has_mask() const {
     return _mask.has_value();
 }
 
+object &object::with_blending(float opacity) {
+    _blended = true;
+    _opacity = opacity;
+    return *this;
+}
+
+bool object::is_blended() const {
+    return _blended;
+}
+
+std::array<GLuint, 4> object::get_textures() const {
+    return {
+        _albedo_texture.value_or(0),
+        _specular_map.value_or(0),
+        _norm_map.value_or(0),
+        _mask.value_or(0)
+    };
+}
+
+void object::update_bbox() {
+    std::tie(_bbox_min, _bbox_max) = compute_bbox(vertices);
+    _has_bbox = true;
+}
+
+bool object::has_bbox() const {
+    return _has_bbox;
+}
+
+std::pair<glm::vec3, glm::vec3> object::get_local_bbox() const {
+    return {_bbox_min, _bbox_max};
+}
+
+std::pair<glm::vec3, glm::vec3> object::get_bbox(const glm::mat4 &model) const {
+    return transform_bbox(get_local_bbox(), model);
+}
+
+bool object::is_visible(const glm::mat4 &transform) const {
+    // count corners outside of each clip plane
+    int outside[6] = {0, 0, 0, 0, 0, 0};
+    for (float x : {_bbox_min.x, _bbox_max.x}) {
+        for (float y : {_bbox_min.y, _bbox_max.y}) {
+            for (float z : {_bbox_min.z, _bbox_max.z}) {
+                glm::vec4 p = transform * glm::vec4(x, y, z, 1.f);
+                outside[0] += p.x < -p.w;
+                outside[1] += p.x > p.w;
+                outside[2] += p.y < -p.w;
+                outside[3] += p.y > p.w;
+                outside[4] += p.z < -p.w;
+                outside[5] += p.z > p.w;
+            }
+        }
+    }
+    for (int count : outside) {
+        if (count == 8) {
+            return false;
+        }
+    }
+    return true;
+}
+
 object &object::with_env_map(GLuint env_map) {
     _env_map = env_map;
     return *this;
 }
+
+object &object::with_specular(const glm::vec3 &specular_color, float specular_power) {
+    _specular_color = specular_color;
+    _specular_power = specular_power;
+    return *this;
+}
@@ -2,13 +2,18 @@
 
 #include <GL/glew.h>
 
+#include <array>
 #include <optional>
+#include <span>
+#include <string>
 #include <functional>
 #include <utility>
 #include <vector>
 
 #include <glm/mat4x4.hpp>
 
+#include "engine/gl_handle.hpp"
+
 #include "utils.hpp"
 #include "shader_program.hpp"
 
@@ -17,8 +22,23 @@ public:
 
     object(std::vector<vertex> vertices, const glm::vec3& specular_color, float specular_power);
 
+    // owns its buffers, a copy would share them
+    object(const object&) = delete;
+    object& operator=(const object&) = delete;
+
+    object(object&&) = default;
+    object& operator=(object&&) = default;
+
     void draw(const shader_program &program, bool use_textures = true, bool use_shadow_map = true);
 
+    // one draw call for the mesh at each of the nodes, usually the visible subset of instances
+    void draw_instances(
+        const shader_program &program,
+        std::span<const int> nodes,
+        bool use_textures = true,
+        bool use_shadow_map = true
+    );
+
     object& with_albedo_texture(GLuint albedo_texture);
 
     object& with_indices(std::vector<int> indices);
@@ -31,15 +51,53 @@ public:
 
     object& with_env_map(GLuint env_map);
 
+    object& with_specular(const glm::vec3& specular_color, float specular_power);
+
+    // drawn in the weighted blended transparency pass, alpha is mask * opacity
+    object& with_blending(float opacity = 1.f);
+
+    // transform nodes of the instances, replaces node
+    object& with_instances(std::vector<int> nodes);
+
+    const std::vector<int>& get_instances() const;
+
     bool has_mask() const;
 
+    bool is_blended() const;
+
+    // textures_mask of the shaders: shadow map, albedo, specular, normal, mask and env bits,
+    // selects the program variant
+    int get_features(bool use_textures = true, bool use_shadow_map = true) const;
+
+    // albedo, specular, normal and mask textures, 0 if not set
+    std::array<GLuint, 4> get_textures() const;
+
+    // false if the bounding box is entirely outside the clip volume,
+    // transform maps object space to clip space
+    bool is_visible(const glm::mat4& transform) const;
+
+    // recomputes the local bounding box from vertices, done by scene_storage for new objects
+    void update_bbox();
+
+    bool has_bbox() const;
+
+    std::pair<glm::vec3, glm::vec3> get_local_bbox() const;
+
+    // bounding box in the space of model
+    std::pair<glm::vec3, glm::vec3> get_bbox(const glm::mat4& model) const;
+
 private:
 
+    void bind(const shader_program &program, bool use_textures, bool use_shadow_map);
+
     std::optional<std::vector<int>> _indices = std::nullopt;
 
-    GLuint _vao = 0;
-    GLuint _vbo = 0;
-    GLuint _ebo = 0;
+    gl_vertex_array _vao;
+    gl_buffer _vbo;
+    gl_buffer _ebo;
+    gl_buffer _instance_vbo;
+
+    std::vector<int> _instances;
 
     std::optional<GLuint> _albedo_texture = std::nullopt;
     std::optional<GLuint> _specular_map = std::nullopt;
@@ -50,10 +108,21 @@ private:
     glm::vec3 _specular_color;
     float _specular_power;
 
+    bool _blended = false;
+    float _opacity = 1.f;
+
+    glm::vec3 _bbox_min = glm::vec3(0.f);
+    glm::vec3 _bbox_max = glm::vec3(0.f);
+    bool _has_bbox = false;
+
 public:
 
     std::vector<vertex> vertices;
-    glm::mat4 model = glm::mat4(1.f);
+    // transform node in the owning scene_storage
+    int node = 0;
+    // mtl file and material name the object was parsed with, empty if none
+    std::string material_library;
+    std::string material;
 
 };
 
@@ -1,9 +1,24 @@
 #include "point_light_object.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 point_light_object::point_light_object(
     const glm::vec3 &position,
     const glm::vec3 &light,
     const glm::vec3& attenuation
 ) : position(position), light(light), attenuation(attenuation) {}
 
-
+float point_light_object::get_radius(float threshold) const {
+    float intensity = std::max({light.x, light.y, light.z});
+    float a = attenuation.z;
+    float b = attenuation.y;
+    float c = attenuation.x - intensity / threshold;
+    if (c >= 0.f) {
+        return 0.f;
+    }
+    if (a <= 0.f) {
+        return b > 0.f ? -c / b : INFINITY;
+    }
+    return (-b + std::sqrt(b * b - 4.f * a * c)) / (2.f * a);
+}
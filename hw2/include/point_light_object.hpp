@@ -8,6 +8,9 @@ public:
 
     point_light_object(const glm::vec3 &position, const glm::vec3 &light, const glm::vec3 &attenuation);
 
+    // distance after which the light contributes less than threshold
+    float get_radius(float threshold) const;
+
 public:
 
     glm::vec3 position;
@@ -1,16 +1,129 @@
 #include "scene_storage.hpp"
 
-void scene_storage::draw_objects(shader_program &program, bool use_textures, bool use_shadow_map) {
-    for (auto& obj: _objects) {
-        obj.draw(program, use_textures, use_shadow_map);
+#include <algorithm>
+#include <iterator>
+
+#include <glm/geometric.hpp>
+
+#include "bounds.hpp"
+
+void scene_storage::draw_objects(
+    shader_program &program,
+    bool use_textures,
+    bool use_shadow_map,
+    const std::optional<glm::mat4>& cull_transform
+) {
+    bind_transforms(program);
+    sort_by_features();
+    // opaque objects first so alpha tested ones are partially rejected by depth
+    draw_list(_objects, program, use_textures, use_shadow_map, cull_transform);
+    draw_list(_objects_with_mask, program, use_textures, use_shadow_map, cull_transform);
+}
+
+void scene_storage::draw_transparent(
+    shader_program &program,
+    const std::optional<glm::mat4>& cull_transform
+) {
+    bind_transforms(program);
+    sort_by_features();
+    draw_list(_blended_objects, program, true, true, cull_transform);
+}
+
+bool scene_storage::has_transparent() const {
+    return !_blended_objects.empty();
+}
+
+void scene_storage::draw_list(
+    std::vector<object> &objects,
+    shader_program &program,
+    bool use_textures,
+    bool use_shadow_map,
+    const std::optional<glm::mat4>& cull_transform
+) {
+    for (auto& obj : objects) {
+        _visible_nodes.clear();
+        for (int node : get_nodes(obj)) {
+            if (!cull_transform.has_value() || obj.is_visible(cull_transform.value() * _world_transforms[node])) {
+                _visible_nodes.push_back(node);
+            }
+        }
+        draw_nodes(obj, program, use_textures, use_shadow_map);
+    }
+}
+
+void scene_storage::draw_objects_layered(
+    shader_program &program,
+    std::span<const glm::mat4> face_transforms,
+    bool use_textures,
+    bool use_shadow_map,
+    int layer_mask
+) {
+    bind_transforms(program);
+    sort_by_features();
+    program.set("face_transforms", face_transforms);
+    for (auto objects : {&_objects, &_objects_with_mask}) {
+        for (auto& obj : *objects) {
+            // instances share one draw, so the mask covers faces of any visible instance
+            int face_mask = 0;
+            _visible_nodes.clear();
+            for (int node : get_nodes(obj)) {
+                int node_mask = 0;
+                for (std::size_t i = 0; i < face_transforms.size(); i++) {
+                    if ((layer_mask & (1 << i)) && obj.is_visible(face_transforms[i] * _world_transforms[node])) {
+                        node_mask |= 1 << i;
+                    }
+                }
+                if (node_mask != 0) {
+                    _visible_nodes.push_back(node);
+                    face_mask |= node_mask;
+                }
+            }
+            if (face_mask != 0) {
+                program.set("face_mask", face_mask);
+                draw_nodes(obj, program, use_textures, use_shadow_map);
+            }
+        }
+    }
+}
+
+void scene_storage::sort_by_features() {
+    if (_sorted) {
+        return;
+    }
+    for (auto objects : {&_objects, &_objects_with_mask, &_blended_objects}) {
+        std::stable_sort(objects->begin(), objects->end(), [](const object& a, const object& b) {
+            return a.get_features() < b.get_features();
+        });
+    }
+    _sorted = true;
+}
+
+std::span<const int> scene_storage::get_nodes(const object &obj) const {
+    if (obj.get_instances().empty()) {
+        return {&obj.node, 1};
+    }
+    return obj.get_instances();
+}
+
+void scene_storage::draw_nodes(object &obj, const shader_program &program, bool use_textures, bool use_shadow_map) {
+    if (_visible_nodes.empty()) {
+        return;
     }
-    for (auto& obj: _objects_with_mask) {
-        obj.draw(program, use_textures, use_shadow_map);
+    const shader_program& variant = program.select(obj.get_features(use_textures, use_shadow_map));
+    if (obj.get_instances().empty()) {
+        obj.draw(variant, use_textures, use_shadow_map);
+    } else {
+        obj.draw_instances(variant, _visible_nodes, use_textures, use_shadow_map);
     }
 }
 
-scene_storage& scene_storage::add_object(object obj) {
-    if (obj.has_mask()) {
+scene_storage& scene_storage::add_object(object obj, int node) {
+    obj.node = node;
+    _bounds_dirty = true;
+    _sorted = false;
+    if (obj.is_blended()) {
+        _blended_objects.push_back(std::move(obj));
+    } else if (obj.has_mask()) {
         _objects_with_mask.push_back(std::move(obj));
     } else {
         _objects.push_back(std::move(obj));
@@ -19,12 +132,161 @@ scene_storage& scene_storage::add_object(object obj) {
 }
 
 scene_storage &scene_storage::apply(const std::function<void(object&)>& func) {
-    for (auto& obj: _objects) {
-        func(obj);
+    // instances and textures may change
+    _bounds_dirty = true;
+    _sorted = false;
+    for (auto objects : {&_objects, &_objects_with_mask, &_blended_objects}) {
+        for (auto& obj : *objects) {
+            func(obj);
+        }
     }
-    for (auto& obj: _objects_with_mask) {
-        func(obj);
+
+    // objects made blended move to the transparent pass
+    for (auto objects : {&_objects, &_objects_with_mask}) {
+        auto it = std::stable_partition(objects->begin(), objects->end(), [](const object& obj) {
+            return !obj.is_blended();
+        });
+        std::move(it, objects->end(), std::back_inserter(_blended_objects));
+        objects->erase(it, objects->end());
     }
     return *this;
 }
 
+GLuint scene_storage::add_texture(gl_texture texture) {
+    _textures.push_back(std::move(texture));
+    return _textures.back();
+}
+
+int scene_storage::add_node(int parent, const glm::mat4 &transform) {
+    _parents.push_back(parent);
+    _local_transforms.push_back(transform);
+    _world_transforms.emplace_back(1.f);
+    _dirty.push_back(true);
+    _node_bounds.push_back(empty_bbox());
+    _node_world_bounds.push_back(empty_bbox());
+    _any_dirty = true;
+    return (int) _parents.size() - 1;
+}
+
+void scene_storage::set_transform(int node, const glm::mat4 &transform) {
+    _local_transforms[node] = transform;
+    _dirty[node] = true;
+    _any_dirty = true;
+}
+
+const glm::mat4 &scene_storage::get_world_transform(int node) {
+    update_transforms();
+    return _world_transforms[node];
+}
+
+void scene_storage::update_bounds() {
+    if (!_bounds_dirty) {
+        return;
+    }
+
+    std::vector<object *> pending;
+    for (auto objects : {&_objects, &_objects_with_mask, &_blended_objects}) {
+        for (auto& obj : *objects) {
+            if (!obj.has_bbox()) {
+                pending.push_back(&obj);
+            }
+        }
+    }
+    parallel_for(pending.size(), [&pending](std::size_t i) {
+        pending[i]->update_bbox();
+    });
+
+    std::fill(_node_bounds.begin(), _node_bounds.end(), empty_bbox());
+    for (auto objects : {&_objects, &_objects_with_mask, &_blended_objects}) {
+        for (auto& obj : *objects) {
+            for (int node : get_nodes(obj)) {
+                _node_bounds[node] = merge_bbox(_node_bounds[node], obj.get_local_bbox());
+            }
+        }
+    }
+
+    std::fill(_dirty.begin(), _dirty.end(), true);
+    _any_dirty = true;
+    _bounds_dirty = false;
+}
+
+void scene_storage::update_transforms() {
+    update_bounds();
+    if (!_any_dirty) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < _parents.size(); i++) {
+        int parent = _parents[i];
+        if (parent >= 0 && _dirty[parent]) {
+            _dirty[i] = true;
+        }
+        if (_dirty[i]) {
+            _world_transforms[i] = parent >= 0
+                ? _world_transforms[parent] * _local_transforms[i]
+                : _local_transforms[i];
+            _node_world_bounds[i] = transform_bbox(_node_bounds[i], _world_transforms[i]);
+        }
+    }
+    std::fill(_dirty.begin(), _dirty.end(), false);
+    _any_dirty = false;
+
+    _bbox = empty_bbox();
+    for (auto& bounds : _node_world_bounds) {
+        _bbox = merge_bbox(_bbox, bounds);
+    }
+
+    if (!_transforms_buffer) {
+        _transforms_buffer = gl_buffer::create();
+        _transforms_texture = gl_texture::create();
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, _transforms_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, _world_transforms.size() * sizeof(glm::mat4), _world_transforms.data(), GL_DYNAMIC_DRAW);
+    glActiveTexture(GL_TEXTURE0 + model_texture_unit);
+    glBindTexture(GL_TEXTURE_BUFFER, _transforms_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _transforms_buffer);
+}
+
+void scene_storage::bind_transforms(const shader_program &program) {
+    update_transforms();
+    glActiveTexture(GL_TEXTURE0 + model_texture_unit);
+    glBindTexture(GL_TEXTURE_BUFFER, _transforms_texture);
+    program.set("model_data", model_texture_unit);
+}
+
+std::pair<glm::vec3, glm::vec3> scene_storage::get_bbox() {
+    update_transforms();
+    return _bbox;
+}
+
+void scene_storage::request_textures(
+    texture_streamer &streamer,
+    const glm::mat4 &view,
+    const glm::mat4 &projection,
+    float viewport_height
+) {
+    update_transforms();
+    glm::mat4 view_projection = projection * view;
+    // pixels per unit of size at unit distance
+    float scale = 0.5f * projection[1][1] * viewport_height;
+
+    for (auto list : {&_objects, &_objects_with_mask, &_blended_objects}) {
+        for (auto& obj : *list) {
+            if (!obj.has_bbox()) {
+                continue;
+            }
+            for (int node : get_nodes(obj)) {
+                if (!obj.is_visible(view_projection * _world_transforms[node])) {
+                    continue;
+                }
+                auto [min, max] = obj.get_bbox(view * _world_transforms[node]);
+                // the closest point may be inside the box
+                float distance = std::max(-max.z, 0.1f);
+                float footprint = glm::length(max - min) * scale / distance;
+                for (GLuint texture : obj.get_textures()) {
+                    streamer.request(texture, footprint);
+                }
+            }
+        }
+    }
+}
@@ -2,22 +2,129 @@
 
 #include <vector>
 #include <functional>
+#include <optional>
+#include <cmath>
+#include <span>
 
+#include <GL/glew.h>
+
+#include <glm/mat4x4.hpp>
+
+#include "engine/gl_handle.hpp"
 #include "object.hpp"
 #include "shader_program.hpp"
+#include "texture_streamer.hpp"
 
+// Objects with a hierarchy of transform nodes. Node 0 is the root; a node's parent
+// always precedes it, so world transforms are updated in a single forward pass
+// and uploaded as one texture buffer read by the vertex shaders.
 class scene_storage {
 public:
 
-    void draw_objects(shader_program& program, bool use_textures = true, bool use_shadow_map = true);
+    // texture unit of the world transforms buffer
+    static constexpr int model_texture_unit = 11;
+
+    void draw_objects(
+        shader_program& program,
+        bool use_textures = true,
+        bool use_shadow_map = true,
+        const std::optional<glm::mat4>& cull_transform = std::nullopt
+    );
+
+    // blended objects, drawn into the targets of transparency_builder
+    void draw_transparent(
+        shader_program& program,
+        const std::optional<glm::mat4>& cull_transform = std::nullopt
+    );
+
+    bool has_transparent() const;
+
+    // draws each object once for all layers it is visible in,
+    // program must select the layer from face_mask and face_transforms
+    void draw_objects_layered(
+        shader_program& program,
+        std::span<const glm::mat4> face_transforms,
+        bool use_textures = true,
+        bool use_shadow_map = true,
+        int layer_mask = -1
+    );
 
-    scene_storage& add_object(object obj);
+    scene_storage& add_object(object obj, int node = 0);
 
     scene_storage& apply(const std::function<void(object&)>& func);
 
+    // keeps a texture alive for the objects, which refer to it by name
+    GLuint add_texture(gl_texture texture);
+
+    // parent -1 makes a node independent of the root
+    int add_node(int parent = 0, const glm::mat4& transform = glm::mat4(1.f));
+
+    // local transform relative to the parent node
+    void set_transform(int node, const glm::mat4& transform);
+
+    const glm::mat4& get_world_transform(int node);
+
+    // maintained from per-node bounds, only moved nodes are recomputed
+    std::pair<glm::vec3, glm::vec3> get_bbox();
+
+    // requests textures of objects in the view frustum with their projected size in pixels
+    void request_textures(
+        texture_streamer& streamer,
+        const glm::mat4& view,
+        const glm::mat4& projection,
+        float viewport_height
+    );
+
 private:
 
+    // local bounding boxes of new objects, computed in parallel, and their union per node
+    void update_bounds();
+
+    // recomputes dirty subtrees and uploads world transforms if any changed
+    void update_transforms();
+
+    void bind_transforms(const shader_program& program);
+
+    void draw_list(
+        std::vector<object>& objects,
+        shader_program& program,
+        bool use_textures,
+        bool use_shadow_map,
+        const std::optional<glm::mat4>& cull_transform
+    );
+
+    // groups objects with the same program variant, keeps the opaque, masked and blended lists
+    void sort_by_features();
+
+    // the object's node, or its instances
+    std::span<const int> get_nodes(const object& obj) const;
+
+    // draws obj at _visible_nodes with the program variant for its features
+    void draw_nodes(object& obj, const shader_program& program, bool use_textures, bool use_shadow_map);
+
     std::vector<object> _objects;
     std::vector<object> _objects_with_mask;
+    std::vector<object> _blended_objects;
+    bool _sorted = true;
+
+    std::vector<int> _parents = {-1};
+    std::vector<glm::mat4> _local_transforms = {glm::mat4(1.f)};
+    std::vector<glm::mat4> _world_transforms = {glm::mat4(1.f)};
+    std::vector<char> _dirty = {true};
+    bool _any_dirty = true;
+
+    // union of local bounds of the objects at each node, and its world bounds
+    std::vector<std::pair<glm::vec3, glm::vec3>> _node_bounds = {{glm::vec3(INFINITY), glm::vec3(-INFINITY)}};
+    std::vector<std::pair<glm::vec3, glm::vec3>> _node_world_bounds = {{glm::vec3(INFINITY), glm::vec3(-INFINITY)}};
+    std::pair<glm::vec3, glm::vec3> _bbox = {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+    bool _bounds_dirty = false;
+
+    // compacted list of instances that passed culling
+    std::vector<int> _visible_nodes;
+
+    gl_buffer _transforms_buffer;
+    gl_texture _transforms_texture;
+
+    std::vector<gl_texture> _textures;
 
 };
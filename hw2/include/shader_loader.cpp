@@ -0,0 +1,40 @@
+#include "shader_loader.hpp"
+
+#include <sstream>
+
+#include "glsl_preprocessor.hpp"
+
+std::string get_shader_file(const char *source) {
+    std::istringstream in(source);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.starts_with("// 0: ")) {
+            return line.substr(6);
+        }
+        if (line.starts_with("#line")) {
+            break;
+        }
+    }
+    return "";
+}
+
+std::string load_shader(
+    const std::filesystem::path &path,
+    const char *embedded_source,
+    std::vector<std::filesystem::path> &files
+) {
+    // defines come before the first #line
+    std::vector<std::string> defines;
+    std::istringstream embedded(embedded_source);
+    std::string line;
+    while (std::getline(embedded, line) && !line.starts_with("#line")) {
+        if (line.starts_with("#define ")) {
+            defines.push_back(line);
+        }
+    }
+
+    glsl_preprocessor preprocessor;
+    std::string result = preprocessor.process(path, defines);
+    files = preprocessor.get_files();
+    return result;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Shaders converted by convertShaderIntoHeader list their files in comments after
+// #version, these functions rebuild the same text from disk for hot reloading.
+
+// path of the shader relative to its directory, empty if source has no file list
+std::string get_shader_file(const char *source);
+
+// resolves includes with the glsl_preprocessor of libs/glslpreprocess and keeps the build
+// time defines of embedded_source, files receives every file read; throws if a file can't
+// be read or is malformed
+std::string load_shader(
+    const std::filesystem::path &path,
+    const char *embedded_source,
+    std::vector<std::filesystem::path> &files
+);
@@ -1,28 +1,442 @@
 #include "shader_program.hpp"
 
-#include "utils.hpp"
+#include <iostream>
+#include <string>
+
+#include "shader_loader.hpp"
+
+namespace {
+
+std::filesystem::path reload_directory;
+std::uint64_t file_generation = 0;
+std::unordered_map<std::string, std::uint64_t> changed_files;
+
+template <typename T>
+void store_value(std::array<std::uint32_t, 16> &data, const T &value) {
+    static_assert(sizeof(T) <= sizeof(data));
+    std::memcpy(data.data(), &value, sizeof(T));
+}
+
+template <typename T>
+T load_value(const std::array<std::uint32_t, 16> &data) {
+    T value;
+    std::memcpy(static_cast<void *>(&value), data.data(), sizeof(T));
+    return value;
+}
+
+}
 
 shader_program::shader_program(const char *vertex_source, const char *fragment_source) {
     init(vertex_source, fragment_source);
 }
 
 void shader_program::init(const char *vertex_source, const char *fragment_source) {
-    _vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_source);
-    _fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_source);
-    _program = create_program(_vertex_shader, _fragment_shader);
+    init({
+        {GL_VERTEX_SHADER, vertex_source},
+        {GL_FRAGMENT_SHADER, fragment_source}
+    });
+}
+
+shader_program::shader_program(const char *vertex_source, const char *geometry_source, const char *fragment_source) {
+    init(vertex_source, geometry_source, fragment_source);
+}
+
+void shader_program::init(const char *vertex_source, const char *geometry_source, const char *fragment_source) {
+    init({
+        {GL_VERTEX_SHADER, vertex_source},
+        {GL_GEOMETRY_SHADER, geometry_source},
+        {GL_FRAGMENT_SHADER, fragment_source}
+    });
+}
+
+void shader_program::init_compute(const char *compute_source) {
+    init({{GL_COMPUTE_SHADER, compute_source}});
+}
+
+void shader_program::init(std::vector<shader_source> sources) {
+    _sources = std::move(sources);
+    _loaded_sources.reset();
+    _files.clear();
+    _file_generation = 0;
+    _program = std::make_shared<gl_program>(create_cached_program(_sources));
+    _with_variants = false;
+    _variants.clear();
+    _selected = nullptr;
+    _forwarded.clear();
+    _uniform_blocks.clear();
+    load_locations();
+}
+
+void shader_program::enable_variants() {
+    _with_variants = true;
+}
+
+const shader_program &shader_program::select(int features) const {
+    if (!_with_variants) {
+        return *this;
+    }
+    auto &variant = _variants[features];
+    if (variant && _selected == variant.get()) {
+        return *variant;
+    }
+
+    if (!variant) {
+        std::string define = "#define FEATURES " + std::to_string(features) + "\n";
+        std::vector<std::string> sources;
+        for (auto [type, source] : _sources) {
+            std::string text(source);
+            std::size_t version = text.find("#version");
+            std::size_t line_end = version == std::string::npos ? 0 : text.find('\n', version);
+            text.insert(line_end == std::string::npos ? text.size() : line_end + 1, define);
+            sources.push_back(std::move(text));
+        }
+        std::vector<shader_source> variant_sources;
+        for (std::size_t i = 0; i < sources.size(); i++) {
+            variant_sources.emplace_back(_sources[i].first, sources[i].c_str());
+        }
+
+        variant = std::make_shared<shader_program>();
+        try {
+            variant->_program = std::make_shared<gl_program>(create_cached_program(variant_sources));
+        } catch (const std::exception &e) {
+            if (!is_reloading()) {
+                throw;
+            }
+            // an edit may break only some variants, those fall back to the run time branches
+            std::cerr << e.what() << std::endl;
+            variant->_program = _program;
+        }
+        variant->load_locations();
+        for (auto &[name, binding] : _uniform_blocks) {
+            variant->bind_uniform_block(name.c_str(), binding);
+        }
+    }
+
+    variant->bind();
+    for (auto &[key, uniform] : _forwarded) {
+        replay(uniform, *variant);
+    }
+    _selected = variant.get();
+    return *variant;
+}
+
+void shader_program::enable_reloading(std::filesystem::path directory) {
+    reload_directory = std::move(directory);
+    file_generation = 1;
+}
+
+void shader_program::notify_changed(const std::filesystem::path &file) {
+    changed_files[file.lexically_normal().string()] = ++file_generation;
+}
+
+bool shader_program::is_reloading() {
+    return file_generation > 0;
+}
+
+void shader_program::reload() const {
+    bool changed = _file_generation == 0;
+    for (auto &file : _files) {
+        auto it = changed_files.find(file.string());
+        changed = changed || (it != changed_files.end() && it->second > _file_generation);
+    }
+    _file_generation = file_generation;
+    if (!changed) {
+        return;
+    }
+
+    auto sources = std::make_shared<std::vector<std::string>>();
+    std::vector<std::filesystem::path> all_files;
+    try {
+        for (auto [type, source] : _sources) {
+            std::string file = get_shader_file(source);
+            if (file.empty()) {
+                sources->emplace_back(source);
+                continue;
+            }
+            std::vector<std::filesystem::path> files;
+            sources->push_back(load_shader(reload_directory / file, source, files));
+            all_files.insert(all_files.end(), files.begin(), files.end());
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return;
+    }
+    _files = std::move(all_files);
+
+    std::vector<shader_source> new_sources;
+    bool same = true;
+    for (std::size_t i = 0; i < _sources.size(); i++) {
+        new_sources.emplace_back(_sources[i].first, (*sources)[i].c_str());
+        same = same && (*sources)[i] == _sources[i].second;
+    }
+    if (same) {
+        return;
+    }
+
+    std::shared_ptr<gl_program> program;
+    try {
+        program = std::make_shared<gl_program>(create_cached_program(new_sources));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return;
+    }
+
+    _variants.clear();
+    _selected = nullptr;
+
+    _program = std::move(program);
+    _sources = std::move(new_sources);
+    _loaded_sources = std::move(sources);
+    load_locations();
+
+    glUseProgram(get_id());
+    for (auto &[name, binding] : _uniform_blocks) {
+        GLuint index = glGetUniformBlockIndex(get_id(), name.c_str());
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(get_id(), index, binding);
+        }
+    }
+    // replaying records the values again
+    auto forwarded = std::move(_forwarded);
+    _forwarded.clear();
+    for (auto &[key, uniform] : forwarded) {
+        replay(uniform, *this);
+    }
+
+    std::cout << "Reloaded";
+    for (auto [type, source] : _sources) {
+        std::cout << " " << get_shader_file(source);
+    }
+    std::cout << std::endl;
+}
+
+void shader_program::load_locations() const {
+    _locations.clear();
+    _values.clear();
+
+    GLint uniform_number = 0;
+    GLint max_length = 0;
+    glGetProgramiv(get_id(), GL_ACTIVE_UNIFORMS, &uniform_number);
+    glGetProgramiv(get_id(), GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::string name(max_length, '\0');
+    for (GLint i = 0; i < uniform_number; i++) {
+        GLsizei length = 0;
+        glGetActiveUniformName(get_id(), i, max_length, &length, name.data());
+        std::string_view key(name.data(), length);
+
+        GLint location = glGetUniformLocation(get_id(), name.c_str());
+        if (location < 0) {
+            // uniform block member
+            continue;
+        }
+        _locations[uniform_name::get_hash(key)] = location;
+        if (key.ends_with("[0]")) {
+            _locations[uniform_name::get_hash(key.substr(0, length - 3))] = location;
+        }
+    }
 }
 
 shader_program::operator GLuint() const {
-    return _program;
+    return get_id();
 }
 
-GLint shader_program::operator[](const std::string& key) const {
-    if (!_locations.contains(key)) {
-        _locations[key] = glGetUniformLocation(_program, key.c_str());
+GLint shader_program::operator[](uniform_name key) const {
+    if (auto it = _locations.find(key.hash); it != _locations.end()) {
+        return it->second;
     }
-    return _locations[key];
+    GLint location = glGetUniformLocation(get_id(), std::string(key.name).c_str());
+    _locations[key.hash] = location;
+    return location;
 }
 
 void shader_program::bind() const {
-    glUseProgram(_program);
+    if (is_reloading() && _file_generation != file_generation && !_sources.empty()) {
+        reload();
+    }
+    glUseProgram(get_id());
+    _selected = nullptr;
+}
+
+void shader_program::bind_uniform_block(const char *name, GLuint binding) const {
+    if (is_recorded()) {
+        _uniform_blocks.emplace_back(name, binding);
+        for (auto &[features, variant] : _variants) {
+            variant->bind_uniform_block(name, binding);
+        }
+    }
+    GLuint index = glGetUniformBlockIndex(get_id(), name);
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(get_id(), index, binding);
+    }
+}
+
+void shader_program::set(uniform_name key, int value) const {
+    if (forward(key, value)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, value)) {
+        glUniform1i(location, value);
+    }
+}
+
+void shader_program::set(uniform_name key, float value) const {
+    if (forward(key, value)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, value)) {
+        glUniform1f(location, value);
+    }
+}
+
+void shader_program::set(uniform_name key, const glm::vec2 &value) const {
+    if (forward(key, value)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, value)) {
+        glUniform2fv(location, 1, reinterpret_cast<const float *>(&value));
+    }
+}
+
+void shader_program::set(uniform_name key, const glm::ivec3 &value) const {
+    if (forward(key, value)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, value)) {
+        glUniform3iv(location, 1, reinterpret_cast<const int *>(&value));
+    }
+}
+
+void shader_program::set(uniform_name key, const glm::vec3 &value) const {
+    if (forward(key, value)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, value)) {
+        glUniform3fv(location, 1, reinterpret_cast<const float *>(&value));
+    }
+}
+
+void shader_program::set(uniform_name key, const glm::mat4 &value) const {
+    if (forward(key, value)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, value)) {
+        glUniformMatrix4fv(location, 1, GL_FALSE, reinterpret_cast<const float *>(&value));
+    }
+}
+
+void shader_program::set(uniform_name key, const glm::ivec4 &value) const {
+    if (forward(key, value)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, value)) {
+        glUniform4iv(location, 1, reinterpret_cast<const int *>(&value));
+    }
+}
+
+void shader_program::set(uniform_name key, std::span<const float> values) const {
+    if (forward(key, values)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, values.data(), values.size_bytes())) {
+        glUniform1fv(location, (GLsizei) values.size(), values.data());
+    }
+}
+
+void shader_program::set(uniform_name key, std::span<const glm::mat4> values) const {
+    if (forward(key, values)) {
+        return;
+    }
+    GLint location = (*this)[key];
+    if (changed(location, values.data(), values.size_bytes())) {
+        glUniformMatrix4fv(location, (GLsizei) values.size(), GL_FALSE, reinterpret_cast<const float *>(values.data()));
+    }
+}
+
+void shader_program::store(forwarded_uniform &uniform, int value) {
+    uniform.type = uniform_type::int_value;
+    store_value(uniform.data, value);
+}
+
+void shader_program::store(forwarded_uniform &uniform, float value) {
+    uniform.type = uniform_type::float_value;
+    store_value(uniform.data, value);
+}
+
+void shader_program::store(forwarded_uniform &uniform, const glm::vec2 &value) {
+    uniform.type = uniform_type::vec2_value;
+    store_value(uniform.data, value);
+}
+
+void shader_program::store(forwarded_uniform &uniform, const glm::ivec3 &value) {
+    uniform.type = uniform_type::ivec3_value;
+    store_value(uniform.data, value);
+}
+
+void shader_program::store(forwarded_uniform &uniform, const glm::vec3 &value) {
+    uniform.type = uniform_type::vec3_value;
+    store_value(uniform.data, value);
+}
+
+void shader_program::store(forwarded_uniform &uniform, const glm::mat4 &value) {
+    uniform.type = uniform_type::mat4_value;
+    store_value(uniform.data, value);
+}
+
+void shader_program::store(forwarded_uniform &uniform, const glm::ivec4 &value) {
+    uniform.type = uniform_type::ivec4_value;
+    store_value(uniform.data, value);
+}
+
+void shader_program::store(forwarded_uniform &uniform, std::span<const float> values) {
+    uniform.type = uniform_type::float_array;
+    uniform.values.assign(values.begin(), values.end());
+}
+
+void shader_program::store(forwarded_uniform &uniform, std::span<const glm::mat4> values) {
+    uniform.type = uniform_type::mat4_array;
+    auto begin = reinterpret_cast<const float *>(values.data());
+    uniform.values.assign(begin, begin + values.size() * 16);
+}
+
+void shader_program::replay(const forwarded_uniform &uniform, const shader_program &program) {
+    uniform_name key(uniform.name);
+    switch (uniform.type) {
+        case uniform_type::int_value:
+            program.set(key, load_value<int>(uniform.data));
+            break;
+        case uniform_type::float_value:
+            program.set(key, load_value<float>(uniform.data));
+            break;
+        case uniform_type::vec2_value:
+            program.set(key, load_value<glm::vec2>(uniform.data));
+            break;
+        case uniform_type::ivec3_value:
+            program.set(key, load_value<glm::ivec3>(uniform.data));
+            break;
+        case uniform_type::vec3_value:
+            program.set(key, load_value<glm::vec3>(uniform.data));
+            break;
+        case uniform_type::mat4_value:
+            program.set(key, load_value<glm::mat4>(uniform.data));
+            break;
+        case uniform_type::ivec4_value:
+            program.set(key, load_value<glm::ivec4>(uniform.data));
+            break;
+        case uniform_type::float_array:
+            program.set(key, std::span<const float>(uniform.values));
+            break;
+        case uniform_type::mat4_array:
+            program.set(key, std::span<const glm::mat4>(
+                reinterpret_cast<const glm::mat4 *>(uniform.values.data()), uniform.values.size() / 16));
+            break;
+    }
 }
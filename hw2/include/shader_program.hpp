@@ -2,8 +2,47 @@
 
 #include <GL/glew.h>
 
-#include <unordered_map>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "engine/gl_handle.hpp"
+#include "engine/program_cache.hpp"
+
+// uniform name with its hash computed at compile time for string literals
+class uniform_name {
+public:
+
+    template <std::size_t N>
+    consteval uniform_name(const char (&name)[N]) : name(name), hash(get_hash(name)) {}
+
+    explicit uniform_name(std::string_view name) : name(name), hash(get_hash(name)) {}
+
+    static constexpr std::uint64_t get_hash(std::string_view name) {
+        std::uint64_t result = 14695981039346656037ull;
+        for (char c : name) {
+            result = (result ^ (std::uint8_t) c) * 1099511628211ull;
+        }
+        return result;
+    }
+
+    std::string_view name;
+    std::uint64_t hash;
+
+};
 
 class shader_program {
 public:
@@ -12,20 +51,162 @@ public:
 
     shader_program(const char *vertex_source, const char *fragment_source);
 
+    shader_program(const char *vertex_source, const char *geometry_source, const char *fragment_source);
+
     void init(const char *vertex_source, const char *fragment_source);
 
+    void init(const char *vertex_source, const char *geometry_source, const char *fragment_source);
+
+    void init_compute(const char *compute_source);
+
+    // specialized copies of the program are compiled with "#define FEATURES n" after #version,
+    // shaders turn their run time feature flags into constants when it is defined
+    void enable_variants();
+
     explicit operator GLuint() const;
 
-    GLint operator[](const std::string& key) const;
+    GLint operator[](uniform_name key) const;
 
+    // binds the program itself, also when a variant was selected
     void bind() const;
 
+    // binds the variant for the features, compiled on first use; uniforms set on this program
+    // are replayed on it and forwarded to it while it's selected.
+    // without variants the program itself is returned, it must be bound
+    const shader_program &select(int features) const;
+
+    void bind_uniform_block(const char *name, GLuint binding) const;
+
+    // development mode: programs made from shaders converted by convertShaderIntoHeader are rebuilt
+    // from the files in directory on their next bind after one of them changed, errors keep the old one
+    static void enable_reloading(std::filesystem::path directory);
+
+    // a shader or an included file was written, see enable_reloading
+    static void notify_changed(const std::filesystem::path &file);
+
+    // set uniform of the bound program, skipped if the value is the same as the last one set
+    void set(uniform_name key, int value) const;
+    void set(uniform_name key, float value) const;
+    void set(uniform_name key, const glm::vec2& value) const;
+    void set(uniform_name key, const glm::ivec3& value) const;
+    void set(uniform_name key, const glm::vec3& value) const;
+    void set(uniform_name key, const glm::mat4& value) const;
+    void set(uniform_name key, const glm::ivec4& value) const;
+    void set(uniform_name key, std::span<const float> values) const;
+    void set(uniform_name key, std::span<const glm::mat4> values) const;
+
 private:
 
-    GLuint _vertex_shader = 0;
-    GLuint _fragment_shader = 0;
-    GLuint _program = 0;
-    mutable std::unordered_map<std::string, GLint> _locations;
+    struct uniform_value {
+        bool valid = false;
+        std::array<std::uint32_t, 16> data{};
+    };
+
+    enum class uniform_type {
+        int_value, float_value, vec2_value, ivec3_value, vec3_value, mat4_value, ivec4_value, float_array, mat4_array
+    };
+
+    // last value set on a program with variants, the name is copied once and
+    // arrays reuse their storage while the size doesn't grow
+    struct forwarded_uniform {
+        std::string name;
+        uniform_type type = uniform_type::int_value;
+        std::array<std::uint32_t, 16> data{};
+        std::vector<float> values;
+    };
+
+    static void store(forwarded_uniform& uniform, int value);
+    static void store(forwarded_uniform& uniform, float value);
+    static void store(forwarded_uniform& uniform, const glm::vec2& value);
+    static void store(forwarded_uniform& uniform, const glm::ivec3& value);
+    static void store(forwarded_uniform& uniform, const glm::vec3& value);
+    static void store(forwarded_uniform& uniform, const glm::mat4& value);
+    static void store(forwarded_uniform& uniform, const glm::ivec4& value);
+    static void store(forwarded_uniform& uniform, std::span<const float> values);
+    static void store(forwarded_uniform& uniform, std::span<const glm::mat4> values);
+
+    static void replay(const forwarded_uniform& uniform, const shader_program& program);
+
+    void load_locations() const;
+
+    void init(std::vector<shader_source> sources);
+
+    static bool is_reloading();
+
+    // loads the sources from disk if any of the files changed and relinks the program
+    void reload() const;
+
+    // uniforms are remembered to be replayed on variants and on reloaded programs
+    bool is_recorded() const {
+        return _with_variants || (is_reloading() && !_sources.empty());
+    }
+
+    // remembers the value for variants, true if it was sent to the selected one
+    template <typename T>
+    bool forward(uniform_name key, const T& value) const {
+        if (!is_recorded()) {
+            return false;
+        }
+        auto& uniform = _forwarded[key.hash];
+        if (uniform.name.empty()) {
+            uniform.name = key.name;
+        }
+        store(uniform, value);
+        if (_selected != nullptr) {
+            _selected->set(key, value);
+            return true;
+        }
+        return false;
+    }
+
+    // values larger than the cache are always sent
+    bool changed(GLint location, const void *value, std::size_t size) const {
+        if (location < 0) {
+            return false;
+        }
+        if (location >= (GLint) _values.size()) {
+            _values.resize(location + 1);
+        }
+        auto& cached = _values[location];
+        if (size > sizeof(cached.data)) {
+            cached.valid = false;
+            return true;
+        }
+        if (cached.valid && std::memcmp(cached.data.data(), value, size) == 0) {
+            return false;
+        }
+        std::memcpy(cached.data.data(), value, size);
+        cached.valid = true;
+        return true;
+    }
+
+    template <typename T>
+    bool changed(GLint location, const T& value) const {
+        return changed(location, &value, sizeof(T));
+    }
+
+    GLuint get_id() const {
+        return _program ? _program->get() : 0;
+    }
+
+    // replaced in place when reloading, shared with copies and with variants that failed to compile,
+    // deleted with its last owner
+    mutable std::shared_ptr<gl_program> _program;
+    mutable std::unordered_map<std::uint64_t, GLint> _locations;
+    mutable std::vector<uniform_value> _values;
+
+    mutable std::vector<shader_source> _sources;
+    // owns _sources after a reload
+    mutable std::shared_ptr<std::vector<std::string>> _loaded_sources;
+    mutable std::vector<std::filesystem::path> _files;
+    // file changes seen by the program, 0 before its sources were loaded from disk
+    mutable std::uint64_t _file_generation = 0;
+    bool _with_variants = false;
+    // shared between copies like the program object itself
+    mutable std::unordered_map<int, std::shared_ptr<shader_program>> _variants;
+    mutable const shader_program *_selected = nullptr;
+    mutable std::unordered_map<std::uint64_t, forwarded_uniform> _forwarded;
+    mutable std::vector<std::pair<std::string, GLuint>> _uniform_blocks;
 
 };
 
@@ -1,40 +1,143 @@
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
 
 #include "shadow_map_builder.hpp"
 #include "shadow_vertex_shader.h"
 #include "shadow_fragment_shader.h"
 
 
-void shadow_map_builder::init(int target_texture, int resolution) {
-    _resolution = resolution;
-    _program.init(shadow_vertex_shader_source, shadow_fragment_shader_source);
-
-    glGenTextures(1, &shadow_map);
-    glActiveTexture(GL_TEXTURE0 + target_texture);
-    glBindTexture(GL_TEXTURE_2D, shadow_map);
+static gl_texture create_moments_texture(int resolution, int format) {
+    gl_texture texture = gl_texture::create();
+    glBindTexture(GL_TEXTURE_2D, texture);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, _resolution, _resolution, 0, GL_RGBA, GL_FLOAT, nullptr);
-
-    glGenRenderbuffers(1, &_rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, _rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _resolution, _resolution);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, resolution, resolution, 0, GL_RGBA, GL_FLOAT, nullptr);
+    return texture;
+}
 
-    glGenFramebuffers(1, &_fbo);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
-    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, shadow_map, 0);
-    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _rbo);
+static gl_renderbuffer create_depth_renderbuffer(int resolution) {
+    gl_renderbuffer rbo = gl_renderbuffer::create();
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, resolution, resolution);
+    return rbo;
+}
 
+static gl_framebuffer create_framebuffer(GLuint texture, GLuint rbo) {
+    gl_framebuffer fbo = gl_framebuffer::create();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0);
+    if (rbo != 0) {
+        glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    }
     if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         throw std::runtime_error("Incomplete framebuffer!");
+    return fbo;
+}
+
+void shadow_map_builder::init(render_target_pool &targets, int target_texture, int resolution, int cascades, bool cached, int format) {
+    if (cascades > max_cascades)
+        throw std::runtime_error("Too many shadow cascades!");
+
+    _resolution = resolution;
+    _cascades = cascades;
+    _format = format;
+    _program.init(shadow_vertex_shader_source, shadow_fragment_shader_source);
+    _program.enable_variants();
+    _program.bind();
+    _program.set("rescaled_moments", rescaled_moments());
+
+    glActiveTexture(GL_TEXTURE0 + target_texture);
+    _render_texture = create_moments_texture(_resolution, _format);
+    _rbo = create_depth_renderbuffer(_resolution);
+    _fbo = create_framebuffer(_render_texture, _rbo);
+
+    if (cached && _cascades == 0) {
+        // _render_texture holds static casters with dynamic ones on top, blurred into shadow_map
+        _static_texture = create_moments_texture(_resolution, _format);
+        _static_rbo = create_depth_renderbuffer(_resolution);
+        _static_fbo = create_framebuffer(_static_texture, _static_rbo);
+
+        _shadow_texture = create_moments_texture(_resolution, _format);
+        shadow_map = _shadow_texture;
+        _shadow_fbo = create_framebuffer(shadow_map, 0);
+
+        _blur.init(targets, target_texture, _render_texture, _format, _resolution, _resolution, _shadow_fbo);
+        return;
+    }
+
+    if (_cascades == 0) {
+        shadow_map = _render_texture;
+        _blur.init(targets, target_texture, shadow_map, _format, _resolution, _resolution, _fbo);
+        return;
+    }
+
+    // cascades are rendered into _render_texture and blurred into their layer
+    _shadow_texture = gl_texture::create();
+    shadow_map = _shadow_texture;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, shadow_map);
+    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, _format, _resolution, _resolution, _cascades, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    _cascade_fbos.resize(_cascades);
+    for (int i = 0; i < _cascades; i++) {
+        _cascade_fbos[i] = gl_framebuffer::create();
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _cascade_fbos[i]);
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, shadow_map, 0, i);
+        if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            throw std::runtime_error("Incomplete framebuffer!");
+    }
+
+    if (cached) {
+        // static casters of every cascade keep their own layer, with depth for the dynamic ones
+        _static_texture = gl_texture::create();
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _static_texture);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, _format, _resolution, _resolution, _cascades, 0, GL_RGBA, GL_FLOAT, nullptr);
+        _static_depth = gl_texture::create();
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _static_depth);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, _resolution, _resolution, _cascades, 0,
+                     GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+        _static_cascade_fbos.resize(_cascades);
+        for (int i = 0; i < _cascades; i++) {
+            _static_cascade_fbos[i] = gl_framebuffer::create();
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _static_cascade_fbos[i]);
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _static_texture, 0, i);
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, _static_depth, 0, i);
+            if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                throw std::runtime_error("Incomplete framebuffer!");
+        }
+        _static_transforms.resize(_cascades);
+        _dynamic_regions.resize(_cascades);
+    }
+
+    _blur.init(targets, target_texture, _render_texture, _format, _resolution, _resolution, _cascade_fbos[0]);
+}
+
+shadow_map_builder::shadow_map_builder(render_target_pool &targets, int target_texture, int resolution, int cascades, bool cached, int format) {
+    init(targets, target_texture, resolution, cascades, cached, format);
+}
 
-    _blur.init(target_texture, shadow_map, GL_RG32F, _resolution, _resolution, _fbo);
+bool shadow_map_builder::rescaled_moments() const {
+    return _format != GL_RG32F;
 }
 
-shadow_map_builder::shadow_map_builder(int target_texture, int resolution) {
-    init(target_texture, resolution);
+void shadow_map_builder::clear(float z) const {
+    float z2 = z * z;
+    if (rescaled_moments()) {
+        z2 = 4.f * (z2 - z) + 1.f;
+    }
+    glClearColor(z, z2, 0.f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void shadow_map_builder::draw(
@@ -43,8 +146,7 @@ void shadow_map_builder::draw(
     const direction_light_object& light_obj
 ) {
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
-    glClearColor(0.f, 0.f, 0.f, 1.f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    clear(0.f);
     glViewport(0, 0, _resolution, _resolution);
 
     glEnable(GL_DEPTH_TEST);
@@ -53,10 +155,10 @@ void shadow_map_builder::draw(
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
 
-    glm::mat4 transform = light_obj.get_transform(bbox);
+    transform = light_obj.get_transform(bbox);
 
     _program.bind();
-    glUniformMatrix4fv(_program["transform"], 1, GL_FALSE, reinterpret_cast<float *>(&transform));
+    _program.set("transform", transform);
 
     for (auto scene : scenes) {
         scene->draw_objects(_program, false, false);
@@ -67,3 +169,244 @@ void shadow_map_builder::draw(
     glGenerateMipmap(GL_TEXTURE_2D);
 
 }
+
+void shadow_map_builder::draw_cached(
+    const std::vector<scene_storage*>& static_scenes,
+    const std::vector<scene_storage*>& dynamic_scenes,
+    const std::pair<glm::vec3, glm::vec3>& bbox,
+    const direction_light_object& light_obj
+) {
+    float light_angle = std::acos(std::clamp(glm::dot(light_obj.direction, _static_direction), -1.f, 1.f));
+    bool static_dirty = !_static_valid || light_angle > cache_angle
+        || bbox.first != _static_bbox.first || bbox.second != _static_bbox.second;
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    glViewport(0, 0, _resolution, _resolution);
+
+    if (static_dirty) {
+        transform = light_obj.get_transform(bbox);
+        _static_direction = light_obj.direction;
+        _static_bbox = bbox;
+        _static_valid = true;
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _static_fbo);
+        clear(0.f);
+
+        _program.bind();
+        _program.set("transform", transform);
+
+        for (auto scene : static_scenes) {
+            scene->draw_objects(_program, false, false);
+        }
+    }
+
+    glm::ivec4 dynamic_region = get_region(dynamic_scenes, transform);
+    composite(_static_fbo, dynamic_scenes, transform, dynamic_region, static_dirty, _dynamic_region, -1);
+}
+
+glm::ivec4 shadow_map_builder::get_region(const std::vector<scene_storage*>& scenes, const glm::mat4& light_transform) const {
+    glm::ivec4 region(0);
+    for (auto scene : scenes) {
+        auto [scene_min, scene_max] = scene->get_bbox();
+        if (scene_min.x > scene_max.x) {
+            continue;
+        }
+        glm::vec2 ndc_min(INFINITY);
+        glm::vec2 ndc_max(-INFINITY);
+        for (float x : {scene_min.x, scene_max.x}) {
+            for (float y : {scene_min.y, scene_max.y}) {
+                for (float z : {scene_min.z, scene_max.z}) {
+                    glm::vec2 ndc = light_transform * glm::vec4(x, y, z, 1.f);
+                    ndc_min = glm::min(ndc_min, ndc);
+                    ndc_max = glm::max(ndc_max, ndc);
+                }
+            }
+        }
+        glm::ivec2 texel_min = glm::clamp(
+            glm::ivec2(glm::floor((ndc_min * 0.5f + 0.5f) * (float) _resolution)) - 1, 0, _resolution);
+        glm::ivec2 texel_max = glm::clamp(
+            glm::ivec2(glm::ceil((ndc_max * 0.5f + 0.5f) * (float) _resolution)) + 1, 0, _resolution);
+        if (texel_min.x >= texel_max.x || texel_min.y >= texel_max.y) {
+            continue;
+        }
+        if (region.x >= region.z) {
+            region = glm::ivec4(texel_min, texel_max);
+        } else {
+            region = glm::ivec4(
+                glm::min(glm::ivec2(region), texel_min),
+                glm::max(glm::ivec2(region.z, region.w), texel_max)
+            );
+        }
+    }
+    return region;
+}
+
+void shadow_map_builder::composite(
+    GLuint static_fbo,
+    const std::vector<scene_storage*>& dynamic_scenes,
+    const glm::mat4& light_transform,
+    const glm::ivec4& dynamic_region,
+    bool static_dirty,
+    glm::ivec4& last_dynamic_region,
+    int fbo
+) {
+    // the region dynamic casters covered last frame has to be restored as well
+    glm::ivec4 region = dynamic_region;
+    if (static_dirty) {
+        region = glm::ivec4(0, 0, _resolution, _resolution);
+    } else if (last_dynamic_region.x < last_dynamic_region.z) {
+        region = region.x < region.z
+            ? glm::ivec4(
+                glm::min(glm::ivec2(region), glm::ivec2(last_dynamic_region)),
+                glm::max(glm::ivec2(region.z, region.w), glm::ivec2(last_dynamic_region.z, last_dynamic_region.w)))
+            : last_dynamic_region;
+    }
+    last_dynamic_region = dynamic_region;
+
+    if (region.x >= region.z || region.y >= region.w) {
+        return;
+    }
+
+    // blur reads up to 2N texels around the region
+    int N = 7;
+    glm::ivec4 source_region = glm::clamp(region + glm::ivec4(-2 * N, -2 * N, 2 * N, 2 * N), 0, _resolution);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+    glBlitFramebuffer(
+        source_region.x, source_region.y, source_region.z, source_region.w,
+        source_region.x, source_region.y, source_region.z, source_region.w,
+        GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST
+    );
+
+    if (dynamic_region.x < dynamic_region.z) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(source_region.x, source_region.y,
+                  source_region.z - source_region.x, source_region.w - source_region.y);
+
+        _program.bind();
+        _program.set("transform", light_transform);
+
+        for (auto scene : dynamic_scenes) {
+            scene->draw_objects(_program, false, false, light_transform);
+        }
+
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    _blur.do_blur(N, 3.f, fbo, region);
+}
+
+void shadow_map_builder::invalidate() {
+    _static_valid = false;
+}
+
+void shadow_map_builder::draw_cascades(
+    const std::vector<scene_storage*>& scenes,
+    const std::pair<glm::vec3, glm::vec3>& bbox,
+    const direction_light_object& light_obj,
+    const glm::mat4& view,
+    float fov, float aspect,
+    float near, float far
+) {
+    update_cascade_transforms(bbox, light_obj, view, fov, aspect, near, far);
+
+    for (int i = 0; i < _cascades; i++) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+        clear(1.f);
+        glViewport(0, 0, _resolution, _resolution);
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+
+        _program.bind();
+        _program.set("transform", cascade_transforms[i]);
+
+        for (auto scene : scenes) {
+            scene->draw_objects(_program, false, false, cascade_transforms[i]);
+        }
+
+        _blur.do_blur(7, 3.f, _cascade_fbos[i]);
+    }
+}
+
+void shadow_map_builder::draw_cascades_cached(
+    const std::vector<scene_storage*>& static_scenes,
+    const std::vector<scene_storage*>& dynamic_scenes,
+    const std::pair<glm::vec3, glm::vec3>& bbox,
+    const direction_light_object& light_obj,
+    const glm::mat4& view,
+    float fov, float aspect,
+    float near, float far
+) {
+    // as in draw_cached the casters follow the light in steps of cache_angle
+    float light_angle = std::acos(std::clamp(glm::dot(light_obj.direction, _static_direction), -1.f, 1.f));
+    if (!_static_valid || light_angle > cache_angle) {
+        _static_direction = light_obj.direction;
+    }
+    direction_light_object static_light = light_obj;
+    static_light.direction = _static_direction;
+    update_cascade_transforms(bbox, static_light, view, fov, aspect, near, far);
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    glViewport(0, 0, _resolution, _resolution);
+
+    for (int i = 0; i < _cascades; i++) {
+        // the transforms are snapped to texels, equal ones see the static casters at the same texels
+        bool static_dirty = !_static_valid || cascade_transforms[i] != _static_transforms[i];
+        if (static_dirty) {
+            _static_transforms[i] = cascade_transforms[i];
+
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _static_cascade_fbos[i]);
+            clear(1.f);
+
+            _program.bind();
+            _program.set("transform", cascade_transforms[i]);
+
+            for (auto scene : static_scenes) {
+                scene->draw_objects(_program, false, false, cascade_transforms[i]);
+            }
+        }
+
+        glm::ivec4 dynamic_region = get_region(dynamic_scenes, cascade_transforms[i]);
+        composite(_static_cascade_fbos[i], dynamic_scenes, cascade_transforms[i], dynamic_region,
+                  static_dirty, _dynamic_regions[i], _cascade_fbos[i]);
+    }
+    _static_valid = true;
+}
+
+void shadow_map_builder::update_cascade_transforms(
+    const std::pair<glm::vec3, glm::vec3>& bbox,
+    const direction_light_object& light_obj,
+    const glm::mat4& view,
+    float fov, float aspect,
+    float near, float far
+) {
+    auto get_split = [&](int i) {
+        float t = (float) i / (float) _cascades;
+        float log_split = near * std::pow(far / near, t);
+        float linear_split = near + (far - near) * t;
+        return cascade_lambda * log_split + (1.f - cascade_lambda) * linear_split;
+    };
+
+    cascade_transforms.resize(_cascades);
+
+    for (int i = 0; i < _cascades; i++) {
+        cascade_transforms[i] = light_obj.get_cascade_transform(
+            bbox, view, fov, aspect, get_split(i), get_split(i + 1), _resolution
+        );
+    }
+}
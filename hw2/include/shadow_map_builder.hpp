@@ -1,5 +1,8 @@
 #pragma once
 
+#include "engine/gl_handle.hpp"
+#include "engine/render_target_pool.hpp"
+
 #include "shader_program.hpp"
 #include "blur_builder.hpp"
 #include "scene_storage.hpp"
@@ -9,11 +12,20 @@
 class shadow_map_builder {
 public:
 
+    static constexpr int max_cascades = 4;
+
     shadow_map_builder() = default;
 
-    void init(int target_texture, int resolution);
+    // cascades > 0 makes shadow_map a GL_TEXTURE_2D_ARRAY with one layer per cascade,
+    // cached keeps static casters in a separate texture for draw_cached or draw_cascades_cached,
+    // format is GL_RG32F, GL_RG16F or GL_RG16, 16 bit formats store rescaled moments
+    // targets lends the intermediate texture of the blur
+    void init(render_target_pool &targets, int target_texture, int resolution, int cascades = 0, bool cached = false, int format = GL_RG32F);
 
-    shadow_map_builder(int target_texture, int resolution);
+    shadow_map_builder(render_target_pool &targets, int target_texture, int resolution, int cascades = 0, bool cached = false, int format = GL_RG32F);
+
+    // moments are stored as (z, 4 * (z^2 - z) + 1) to spend the precision on the variance
+    bool rescaled_moments() const;
 
     void draw(
         const std::vector<scene_storage*>& scenes,
@@ -21,11 +33,90 @@ public:
         const direction_light_object& light_obj
     );
 
+    // static scenes are redrawn only when the light turns more than cache_angle or bbox changes,
+    // dynamic scenes are composited on top and only their region is blurred again
+    void draw_cached(
+        const std::vector<scene_storage*>& static_scenes,
+        const std::vector<scene_storage*>& dynamic_scenes,
+        const std::pair<glm::vec3, glm::vec3>& bbox,
+        const direction_light_object& light_obj
+    );
+
+    // forces static casters to be redrawn by the next draw_cached or draw_cascades_cached
+    void invalidate();
+
+    void draw_cascades(
+        const std::vector<scene_storage*>& scenes,
+        const std::pair<glm::vec3, glm::vec3>& bbox,
+        const direction_light_object& light_obj,
+        const glm::mat4& view,
+        float fov, float aspect,
+        float near, float far
+    );
+
+    // static casters of a cascade are redrawn only when its texel snapped transform changes:
+    // the camera moved by a texel of the cascade, the light turned more than cache_angle or bbox changed;
+    // dynamic casters are composited as in draw_cached
+    void draw_cascades_cached(
+        const std::vector<scene_storage*>& static_scenes,
+        const std::vector<scene_storage*>& dynamic_scenes,
+        const std::pair<glm::vec3, glm::vec3>& bbox,
+        const direction_light_object& light_obj,
+        const glm::mat4& view,
+        float fov, float aspect,
+        float near, float far
+    );
+
 private:
 
-    GLuint _fbo = 0;
-    GLuint _rbo = 0;
+    void clear(float z) const;
+
+    void update_cascade_transforms(
+        const std::pair<glm::vec3, glm::vec3>& bbox,
+        const direction_light_object& light_obj,
+        const glm::mat4& view,
+        float fov, float aspect,
+        float near, float far
+    );
+
+    // texels covered by the scenes in a map rendered with light_transform, empty if x >= z
+    glm::ivec4 get_region(const std::vector<scene_storage*>& scenes, const glm::mat4& light_transform) const;
+
+    // copies static casters from static_fbo into _fbo, draws the dynamic ones on top and blurs
+    // the changed texels into fbo; last_dynamic_region is restored and replaced with dynamic_region
+    void composite(
+        GLuint static_fbo,
+        const std::vector<scene_storage*>& dynamic_scenes,
+        const glm::mat4& light_transform,
+        const glm::ivec4& dynamic_region,
+        bool static_dirty,
+        glm::ivec4& last_dynamic_region,
+        int fbo
+    );
+
+    gl_framebuffer _fbo;
+    gl_renderbuffer _rbo;
     int _resolution = 0;
+    int _cascades = 0;
+    int _format = GL_RG32F;
+    gl_texture _render_texture;
+    std::vector<gl_framebuffer> _cascade_fbos;
+
+    gl_texture _static_texture;
+    gl_renderbuffer _static_rbo;
+    gl_framebuffer _static_fbo;
+    gl_framebuffer _shadow_fbo;
+    // shadow_map when cached or with cascades, otherwise it's _render_texture
+    gl_texture _shadow_texture;
+    bool _static_valid = false;
+    glm::vec3 _static_direction{};
+    std::pair<glm::vec3, glm::vec3> _static_bbox{};
+    glm::ivec4 _dynamic_region{};
+    // cascade mode: layers of _static_texture and _static_depth, transforms they were drawn with
+    gl_texture _static_depth;
+    std::vector<gl_framebuffer> _static_cascade_fbos;
+    std::vector<glm::mat4> _static_transforms;
+    std::vector<glm::ivec4> _dynamic_regions;
     shader_program _program;
     blur_builder _blur;
 
@@ -33,4 +124,13 @@ public:
 
     GLuint shadow_map = 0;
 
+    // transform the shadow map was rendered with
+    glm::mat4 transform = glm::mat4(1.f);
+
+    float cache_angle = 0.02f;
+
+    // blend between logarithmic (1) and linear (0) cascade splits
+    float cascade_lambda = 0.75f;
+    std::vector<glm::mat4> cascade_transforms;
+
 };
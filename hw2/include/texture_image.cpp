@@ -0,0 +1,247 @@
+#include "texture_image.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "stb_image.h"
+
+namespace {
+
+// 2x2 box filter, odd sizes repeat the last row or column
+std::vector<std::uint8_t> downsample(const std::vector<std::uint8_t>& src, int width, int height) {
+    int new_width = std::max(1, width / 2);
+    int new_height = std::max(1, height / 2);
+    std::vector<std::uint8_t> result((std::size_t) new_width * new_height * 3);
+    for (int y = 0; y < new_height; y++) {
+        int y0 = std::min(2 * y, height - 1);
+        int y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < new_width; x++) {
+            int x0 = std::min(2 * x, width - 1);
+            int x1 = std::min(2 * x + 1, width - 1);
+            for (int c = 0; c < 3; c++) {
+                int sum = src[(y0 * width + x0) * 3 + c] + src[(y0 * width + x1) * 3 + c]
+                    + src[(y1 * width + x0) * 3 + c] + src[(y1 * width + x1) * 3 + c];
+                result[(y * new_width + x) * 3 + c] = (std::uint8_t) ((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+std::uint32_t read_uint(std::ifstream& in) {
+    unsigned char bytes[4] = {};
+    in.read(reinterpret_cast<char *>(bytes), 4);
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((std::uint32_t) bytes[3] << 24);
+}
+
+// bytes per 4x4 block, 0 for formats the container doesn't hold
+std::uint64_t get_block_size(GLenum format) {
+    switch (format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+            return 8;
+        case GL_COMPRESSED_RG_RGTC2:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// RGB texels of BC1 blocks in the row order of the blocks, as decode_image leaves them
+std::vector<std::uint8_t> decode_bc1(const std::vector<std::uint8_t>& blocks, int width, int height) {
+    std::vector<std::uint8_t> result((std::size_t) width * height * 3);
+    const std::uint8_t *block = blocks.data();
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4, block += 8) {
+            int endpoints[2] = {block[0] | (block[1] << 8), block[2] | (block[3] << 8)};
+            int colors[4][3];
+            for (int e = 0; e < 2; e++) {
+                colors[e][0] = ((endpoints[e] >> 11) & 31) * 255 / 31;
+                colors[e][1] = ((endpoints[e] >> 5) & 63) * 255 / 63;
+                colors[e][2] = (endpoints[e] & 31) * 255 / 31;
+            }
+            for (int c = 0; c < 3; c++) {
+                // the larger endpoint first selects four colors, else three and black
+                if (endpoints[0] > endpoints[1]) {
+                    colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+                    colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+                } else {
+                    colors[2][c] = (colors[0][c] + colors[1][c]) / 2;
+                    colors[3][c] = 0;
+                }
+            }
+            std::uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((std::uint32_t) block[7] << 24);
+            for (int i = 0; i < 16; i++) {
+                int x = bx + i % 4;
+                int y = by + i / 4;
+                if (x >= width || y >= height) {
+                    continue;
+                }
+                const int *color = colors[(indices >> (2 * i)) & 3];
+                for (int c = 0; c < 3; c++) {
+                    result[((std::size_t) y * width + x) * 3 + c] = (std::uint8_t) color[c];
+                }
+            }
+        }
+    }
+    return result;
+}
+
+// larger than any GL_MAX_TEXTURE_SIZE, keeps the level sizes far from overflowing
+const std::uint32_t max_image_size = 1 << 16;
+
+bool is_supported(GLenum format) {
+    switch (format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            return GLEW_EXT_texture_compression_s3tc;
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_RG_RGTC2:
+            // core since 3.0
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
+
+bool texture_image::is_compressed() const {
+    return format != GL_RGB8;
+}
+
+void texture_image::upload_level(int level) const {
+    int level_width = std::max(1, width >> level);
+    int level_height = std::max(1, height >> level);
+    if (is_compressed()) {
+        glCompressedTexImage2D(
+            GL_TEXTURE_2D, level, format,
+            level_width, level_height, 0,
+            (GLsizei) mips[level].size(), mips[level].data()
+        );
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(
+        GL_TEXTURE_2D, level, GL_RGB8,
+        level_width, level_height, 0,
+        GL_RGB, GL_UNSIGNED_BYTE, mips[level].data()
+    );
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+std::string get_compressed_path(const std::string &path) {
+    auto dot = path.rfind('.');
+    auto slash = path.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + ".bctx";
+    }
+    return path.substr(0, dot) + ".bctx";
+}
+
+std::optional<texture_image> read_compressed_image(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    if (!in.read(magic, 4) || !std::equal(magic, magic + 4, "BCTX")) {
+        return std::nullopt;
+    }
+
+    in.seekg(0, std::ios::end);
+    std::uint64_t file_size = (std::uint64_t) in.tellg();
+    in.seekg(4);
+
+    texture_image result;
+    result.format = read_uint(in);
+    std::uint32_t width = read_uint(in);
+    std::uint32_t height = read_uint(in);
+    std::uint32_t level_number = read_uint(in);
+    if (!in || get_block_size(result.format) == 0) {
+        return std::nullopt;
+    }
+
+    // a truncated or corrupt header must not make us allocate what it claims
+    if (width == 0 || height == 0 || width > max_image_size || height > max_image_size) {
+        return std::nullopt;
+    }
+    std::uint32_t max_levels = 1;
+    while ((std::max(width, height) >> max_levels) > 0) {
+        max_levels++;
+    }
+    if (level_number == 0 || level_number > max_levels) {
+        return std::nullopt;
+    }
+    result.width = (int) width;
+    result.height = (int) height;
+
+    std::uint64_t block_size = get_block_size(result.format);
+    for (std::uint32_t level = 0; level < level_number; level++) {
+        std::uint64_t level_width = std::max<std::uint32_t>(1, width >> level);
+        std::uint64_t level_height = std::max<std::uint32_t>(1, height >> level);
+        std::uint64_t expected = (level_width + 3) / 4 * ((level_height + 3) / 4) * block_size;
+        std::uint64_t size = read_uint(in);
+        if (!in || size != expected || (std::uint64_t) in.tellg() + size > file_size) {
+            return std::nullopt;
+        }
+        auto& mip = result.mips.emplace_back(size);
+        in.read(reinterpret_cast<char *>(mip.data()), (std::streamsize) mip.size());
+    }
+    if (!in) {
+        return std::nullopt;
+    }
+
+    // BC1 needs EXT_texture_compression_s3tc, which is not core, the blocks are decoded
+    // here without it since the container may be all there is of the image
+    if (!is_supported(result.format)) {
+        for (std::uint32_t level = 0; level < level_number; level++) {
+            int level_width = std::max<int>(1, result.width >> level);
+            int level_height = std::max<int>(1, result.height >> level);
+            result.mips[level] = decode_bc1(result.mips[level], level_width, level_height);
+        }
+        result.format = GL_RGB8;
+    }
+    return result;
+}
+
+std::optional<texture_image> read_current_compressed_image(const std::string &path) {
+    std::string compressed_path = get_compressed_path(path);
+    std::error_code error;
+    auto compressed_time = std::filesystem::last_write_time(compressed_path, error);
+    if (error) {
+        return std::nullopt;
+    }
+    // without the source the container is all there is
+    auto source_time = std::filesystem::last_write_time(path, error);
+    if (!error && compressed_time < source_time) {
+        return std::nullopt;
+    }
+    return read_compressed_image(compressed_path);
+}
+
+std::optional<texture_image> decode_image(const std::string &path) {
+    texture_image result;
+    int channels;
+    // runs on streamer workers, the global flag would race with parse_scene
+    stbi_set_flip_vertically_on_load_thread(1);
+    unsigned char *pixels = stbi_load(path.c_str(), &result.width, &result.height, &channels, 3);
+    if (pixels == nullptr) {
+        return std::nullopt;
+    }
+    result.mips.emplace_back(pixels, pixels + (std::size_t) result.width * result.height * 3);
+    stbi_image_free(pixels);
+
+    for (int level = 0; (result.width >> level) > 1 || (result.height >> level) > 1; level++) {
+        result.mips.push_back(downsample(
+            result.mips.back(),
+            std::max(1, result.width >> level),
+            std::max(1, result.height >> level)
+        ));
+    }
+    return result;
+}
+
+std::optional<texture_image> load_image(const std::string &path) {
+    if (auto result = read_current_compressed_image(path)) {
+        return result;
+    }
+    return decode_image(path);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Texture with its whole mip chain in CPU memory, either decoded RGB
+// or blocks from the container written by libs/texcompress.
+struct texture_image {
+    // GL_RGB8 or a compressed internal format
+    GLenum format = GL_RGB8;
+    int width = 0;
+    int height = 0;
+    // level 0 first
+    std::vector<std::vector<std::uint8_t>> mips;
+
+    bool is_compressed() const;
+
+    // specifies the level of the texture bound to GL_TEXTURE_2D
+    void upload_level(int level) const;
+};
+
+// path of the compressed container for an image, the extension is replaced by .bctx
+std::string get_compressed_path(const std::string& path);
+
+// nullopt if there is no container or its header doesn't match the data,
+// BC1 blocks come decoded to GL_RGB8 when the context has no S3TC
+std::optional<texture_image> read_compressed_image(const std::string& path);
+
+// the container next to the image, nullopt as well if it's older than the image
+std::optional<texture_image> read_current_compressed_image(const std::string& path);
+
+// decodes the image and builds RGB mips with a box filter
+std::optional<texture_image> decode_image(const std::string& path);
+
+// compressed container next to the image if there is a current one, decoded image otherwise
+std::optional<texture_image> load_image(const std::string& path);
@@ -0,0 +1,231 @@
+#include "texture_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+texture_streamer::texture_streamer(int scratch_texture, int worker_number) {
+    init(scratch_texture, worker_number);
+}
+
+texture_streamer::~texture_streamer() {
+    for (auto& worker : _workers) {
+        worker.request_stop();
+    }
+    _condition.notify_all();
+}
+
+void texture_streamer::init(int scratch_texture, int worker_number) {
+    _scratch_texture = scratch_texture;
+    for (int i = 0; i < worker_number; i++) {
+        _workers.emplace_back([this](std::stop_token stop) {
+            work(stop);
+        });
+    }
+}
+
+GLuint texture_streamer::load(const std::string &path, glm::vec3 placeholder) {
+    if (auto it = _paths.find(path); it != _paths.end()) {
+        return it->second;
+    }
+
+    entry e;
+    e.texture = gl_texture::create();
+    glActiveTexture(GL_TEXTURE0 + _scratch_texture);
+    glBindTexture(GL_TEXTURE_2D, e.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    std::uint8_t texel[3];
+    for (int c = 0; c < 3; c++) {
+        texel[c] = (std::uint8_t) std::clamp(placeholder[c] * 255.f + 0.5f, 0.f, 255.f);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    std::size_t index = _entries.size();
+    _indices[e.texture] = index;
+    _paths[path] = e.texture;
+    _entries.push_back(std::move(e));
+
+    {
+        std::lock_guard lock(_mutex);
+        _jobs.emplace_back(index, path);
+        _pending++;
+    }
+    _condition.notify_one();
+
+    return _entries.back().texture;
+}
+
+bool texture_streamer::reload(const std::string &path) {
+    auto changed = std::filesystem::path(path).lexically_normal();
+    for (auto& [source, texture] : _paths) {
+        if (std::filesystem::path(source).lexically_normal() != changed
+            && std::filesystem::path(get_compressed_path(source)).lexically_normal() != changed) {
+            continue;
+        }
+        {
+            std::lock_guard lock(_mutex);
+            _jobs.emplace_back(_indices[texture], source);
+            _pending++;
+        }
+        _condition.notify_one();
+        return true;
+    }
+    return false;
+}
+
+void texture_streamer::request(GLuint texture, float footprint) {
+    auto it = _indices.find(texture);
+    if (it == _indices.end()) {
+        return;
+    }
+    auto& e = _entries[it->second];
+    if (e.last_used != _frame) {
+        e.footprint = 0.f;
+    }
+    e.footprint = std::max(e.footprint, footprint);
+    e.last_used = _frame;
+}
+
+void texture_streamer::work(std::stop_token stop) {
+    while (true) {
+        std::pair<std::size_t, std::string> job;
+        {
+            std::unique_lock lock(_mutex);
+            if (!_condition.wait(lock, stop, [this] { return !_jobs.empty(); })) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        auto result = load_image(job.second);
+
+        std::lock_guard lock(_mutex);
+        // keeps the placeholder if the file can't be loaded
+        if (result.has_value()) {
+            _decoded.emplace_back(job.first, std::move(result.value()));
+        }
+        _pending--;
+        _decoded_condition.notify_all();
+    }
+}
+
+void texture_streamer::wait_decoded() {
+    std::unique_lock lock(_mutex);
+    _decoded_condition.wait(lock, [this] { return _pending == 0; });
+}
+
+int texture_streamer::get_wanted_level(const entry &e) const {
+    if (e.last_used + unused_frames < _frame) {
+        return e.tail_level;
+    }
+    // one texel per pixel of the footprint
+    float size = (float) std::max(e.data.width, e.data.height);
+    int level = (int) std::floor(std::log2(size / std::max(e.footprint, 1.f)));
+    return std::clamp(level, 0, e.tail_level);
+}
+
+void texture_streamer::upload_level(entry &e, int level) {
+    glActiveTexture(GL_TEXTURE0 + _scratch_texture);
+    glBindTexture(GL_TEXTURE_2D, e.texture);
+    e.data.upload_level(level);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+    e.resident_level = level;
+    _resident_bytes += e.data.mips[level].size();
+}
+
+void texture_streamer::evict_level(entry &e) {
+    int level = e.resident_level;
+    glActiveTexture(GL_TEXTURE0 + _scratch_texture);
+    glBindTexture(GL_TEXTURE_2D, e.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    // a zero sized level releases its memory
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, 0, 0, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+
+    e.resident_level = level + 1;
+    _resident_bytes -= e.data.mips[level].size();
+}
+
+void texture_streamer::update() {
+    _frame++;
+
+    std::vector<std::pair<std::size_t, texture_image>> decoded;
+    {
+        std::lock_guard lock(_mutex);
+        decoded.swap(_decoded);
+    }
+
+    // the whole mip tail replaces the placeholder at once
+    for (auto& [index, data] : decoded) {
+        auto& e = _entries[index];
+        // a reloaded texture drops all its old levels
+        for (int level = e.resident_level; level < (int) e.data.mips.size(); level++) {
+            _resident_bytes -= e.data.mips[level].size();
+        }
+        e.data = std::move(data);
+        int last_level = (int) e.data.mips.size() - 1;
+        e.tail_level = 0;
+        while (e.tail_level < last_level
+               && std::max(e.data.width >> e.tail_level, e.data.height >> e.tail_level) > tail_size) {
+            e.tail_level++;
+        }
+
+        glActiveTexture(GL_TEXTURE0 + _scratch_texture);
+        glBindTexture(GL_TEXTURE_2D, e.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last_level);
+        for (int level = 0; level < e.tail_level; level++) {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, 0, 0, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        }
+        for (int level = last_level; level >= e.tail_level; level--) {
+            upload_level(e, level);
+        }
+    }
+
+    std::vector<entry *> streamed;
+    for (auto& e : _entries) {
+        if (!e.data.mips.empty()) {
+            streamed.push_back(&e);
+        }
+    }
+
+    // least recently used first, then smallest footprint
+    std::sort(streamed.begin(), streamed.end(), [](const entry *a, const entry *b) {
+        return a->last_used != b->last_used ? a->last_used < b->last_used : a->footprint < b->footprint;
+    });
+
+    // unneeded mips go first, then needed ones of the least recently used textures
+    for (auto e : streamed) {
+        while (_resident_bytes > budget_bytes && e->resident_level < get_wanted_level(*e)) {
+            evict_level(*e);
+        }
+    }
+    for (auto e : streamed) {
+        while (_resident_bytes > budget_bytes && e->resident_level < e->tail_level) {
+            evict_level(*e);
+        }
+    }
+
+    // one level per texture per round, largest footprint first
+    std::reverse(streamed.begin(), streamed.end());
+    std::size_t uploaded = 0;
+    for (bool progress = true; progress && uploaded < upload_bytes_per_frame;) {
+        progress = false;
+        for (auto e : streamed) {
+            if (e->resident_level <= get_wanted_level(*e)) {
+                continue;
+            }
+            std::size_t bytes = e->data.mips[e->resident_level - 1].size();
+            if (_resident_bytes + bytes > budget_bytes || uploaded >= upload_bytes_per_frame) {
+                continue;
+            }
+            upload_level(*e, e->resident_level - 1);
+            uploaded += bytes;
+            progress = true;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/vec3.hpp>
+
+#include "engine/gl_handle.hpp"
+#include "texture_image.hpp"
+
+// Loads textures in the background, compressed ones if converted by libs/texcompress.
+// A placeholder texel is available at once, the mip tail is uploaded as soon as
+// the image is loaded and finer mips follow in order of requested on-screen footprint. Resident mips are kept under
+// budget_bytes by dropping the finest mips of the least recently used textures.
+class texture_streamer {
+public:
+
+    texture_streamer() = default;
+
+    explicit texture_streamer(int scratch_texture, int worker_number = 2);
+
+    ~texture_streamer();
+
+    texture_streamer(const texture_streamer&) = delete;
+    texture_streamer& operator=(const texture_streamer&) = delete;
+
+    // scratch_texture is the unit textures are bound to for uploads
+    void init(int scratch_texture, int worker_number = 2);
+
+    // returns a usable texture immediately, the same file is loaded once
+    GLuint load(const std::string& path, glm::vec3 placeholder = glm::vec3(0.5f));
+
+    // texture covers about footprint pixels on screen this frame, unknown textures are ignored
+    void request(GLuint texture, float footprint);
+
+    // decodes a loaded file again after it changed on disk, the texture name is kept,
+    // path may also be the compressed version, false if it is not a loaded texture
+    bool reload(const std::string& path);
+
+    // blocks until all queued files are decoded, their tails are uploaded by the next update
+    void wait_decoded();
+
+    // uploads decoded images, evicts and streams mips, call once per frame
+    void update();
+
+    std::size_t budget_bytes = 256u << 20;
+    std::size_t upload_bytes_per_frame = 4u << 20;
+    // mips up to this size are uploaded together right after decoding
+    int tail_size = 64;
+    // frames after which an unrequested texture falls back to its tail
+    int unused_frames = 120;
+
+private:
+
+    struct entry {
+        gl_texture texture;
+        // CPU copy kept to re-upload evicted mips, empty until decoded
+        texture_image data;
+        int tail_level = 0;
+        // finest uploaded level, mip count while only the placeholder is there
+        int resident_level = 0;
+        float footprint = 0.f;
+        std::uint64_t last_used = 0;
+    };
+
+    void work(std::stop_token stop);
+
+    void upload_level(entry& e, int level);
+
+    void evict_level(entry& e);
+
+    int get_wanted_level(const entry& e) const;
+
+    std::vector<entry> _entries;
+    std::unordered_map<GLuint, std::size_t> _indices;
+    std::unordered_map<std::string, GLuint> _paths;
+
+    // guards _jobs, _decoded and _pending shared with the workers
+    std::mutex _mutex;
+    std::condition_variable_any _condition;
+    std::condition_variable _decoded_condition;
+    std::deque<std::pair<std::size_t, std::string>> _jobs;
+    std::vector<std::pair<std::size_t, texture_image>> _decoded;
+    // queued or being decoded
+    std::size_t _pending = 0;
+
+    std::vector<std::jthread> _workers;
+
+    int _scratch_texture = 0;
+    std::size_t _resident_bytes = 0;
+    std::uint64_t _frame = 0;
+
+};
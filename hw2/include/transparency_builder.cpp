@@ -0,0 +1,93 @@
+#include <stdexcept>
+#include "transparency_builder.hpp"
+#include "blur_vertex_shader.h"
+#include "oit_composite_fragment_shader.h"
+
+transparency_builder::transparency_builder(int first_texture, int width, int height) {
+    init(first_texture, width, height);
+}
+
+void transparency_builder::init(int first_texture, int width, int height) {
+    _first_texture = first_texture;
+    _program = shader_program(blur_vertex_shader_source, oit_composite_fragment_shader_source);
+
+    _vao = gl_vertex_array::create();
+
+    glActiveTexture(GL_TEXTURE0 + first_texture);
+    for (gl_texture *texture : {&_accumulation_texture, &_weights_texture}) {
+        *texture = gl_texture::create();
+        glBindTexture(GL_TEXTURE_2D, *texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    _rbo = gl_renderbuffer::create();
+
+    resize(width, height);
+
+    _fbo = gl_framebuffer::create();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _accumulation_texture, 0);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, _weights_texture, 0);
+    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _rbo);
+    GLenum buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, buffers);
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete framebuffer!");
+}
+
+void transparency_builder::resize(int width, int height) {
+    _width = width;
+    _height = height;
+
+    glActiveTexture(GL_TEXTURE0 + _first_texture);
+    glBindTexture(GL_TEXTURE_2D, _accumulation_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, _weights_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width, height, 0, GL_RED, GL_FLOAT, nullptr);
+
+    // same format as the default framebuffer so depth can be blitted
+    glBindRenderbuffer(GL_RENDERBUFFER, _rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+}
+
+void transparency_builder::begin(GLuint fbo) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+    glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    const float accumulation_clear[] = {0.f, 0.f, 0.f, 1.f};
+    const float weights_clear[] = {0.f, 0.f, 0.f, 0.f};
+    glClearBufferfv(GL_COLOR, 0, accumulation_clear);
+    glClearBufferfv(GL_COLOR, 1, weights_clear);
+
+    // GL 3.3 has no per-target blend functions: color and weights add up,
+    // the accumulation alpha multiplies into the revealage
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void transparency_builder::end(GLuint fbo) {
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    glViewport(0, 0, _width, _height);
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+
+    glActiveTexture(GL_TEXTURE0 + _first_texture);
+    glBindTexture(GL_TEXTURE_2D, _accumulation_texture);
+    glActiveTexture(GL_TEXTURE0 + _first_texture + 1);
+    glBindTexture(GL_TEXTURE_2D, _weights_texture);
+
+    _program.bind();
+    _program.set("accumulation", _first_texture);
+    _program.set("weights", _first_texture + 1);
+    glBindVertexArray(_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "engine/gl_handle.hpp"
+#include "shader_program.hpp"
+
+// Weighted blended order-independent transparency: blended objects accumulate into
+// offscreen targets tested against the opaque depth, then are composited in one pass.
+class transparency_builder {
+public:
+
+    transparency_builder() = default;
+
+    transparency_builder(int first_texture, int width, int height);
+
+    void init(int first_texture, int width, int height);
+
+    void resize(int width, int height);
+
+    // binds the accumulation targets with depth copied from fbo and sets up blending
+    void begin(GLuint fbo = 0);
+
+    // composites the accumulated layers over fbo and restores opaque state
+    void end(GLuint fbo = 0);
+
+private:
+
+    gl_framebuffer _fbo;
+    gl_renderbuffer _rbo;
+    gl_texture _accumulation_texture;
+    gl_texture _weights_texture;
+    gl_vertex_array _vao;
+    int _first_texture = 0;
+    int _width = 0;
+    int _height = 0;
+    shader_program _program;
+
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstring>
+
+#include "engine/gl_handle.hpp"
+
+// std140 uniform block shared between programs, T must match the block layout
+template <typename T>
+class uniform_buffer {
+public:
+
+    uniform_buffer() = default;
+
+    explicit uniform_buffer(GLuint binding) {
+        init(binding);
+    }
+
+    void init(GLuint binding) {
+        _binding = binding;
+        _ubo = gl_buffer::create();
+        glBindBuffer(GL_UNIFORM_BUFFER, _ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, _binding, _ubo);
+    }
+
+    // uploads value only if it differs from the last uploaded one
+    void update(const T& value) {
+        if (_valid && std::memcmp(&_value, &value, sizeof(T)) == 0) {
+            return;
+        }
+        std::memcpy(&_value, &value, sizeof(T));
+        _valid = true;
+        glBindBuffer(GL_UNIFORM_BUFFER, _ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &_value);
+    }
+
+    const T& value() const {
+        return _value;
+    }
+
+    GLuint binding() const {
+        return _binding;
+    }
+
+private:
+
+    gl_buffer _ubo;
+    GLuint _binding = 0;
+    bool _valid = false;
+    T _value{};
+
+};
@@ -4,6 +4,9 @@
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
 
+// shader and program helpers live in the engine
+#include "engine/gl_utils.hpp"
+
 struct vertex {
     glm::vec3 position;
     glm::vec3 normal;
@@ -11,7 +14,3 @@ struct vertex {
 };
 
 void init_vao_vertex(GLuint vao);
-
-GLuint create_shader(GLenum type, const char *source);
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader);
@@ -1,3 +1,4 @@
+#include <filesystem>
 #include <fstream>
 #include <string>
 #include <sstream>
@@ -8,6 +9,7 @@
 #include "stb_image.h"
 
 #include "wavefront_parser.hpp"
+#include "texture_image.hpp"
 
 struct hash {
     std::size_t operator()(const std::tuple<std::size_t, std::size_t, std::size_t>& k) const {
@@ -31,9 +33,48 @@ struct mtl_items {
     GLuint mask = -1;
     glm::vec3 specular_color{};
     float specular_power{};
+    // d, or 1 - Tr when the material has no d; blended below 1
+    float opacity = 1.f;
+    bool has_dissolve = false;
 };
 
-std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool with_textures) {
+// placeholder is shown until a streamed texture is decoded, the others are owned by scene
+GLuint load_texture(const std::string& path, scene_storage& scene, texture_streamer *streamer, glm::vec3 placeholder) {
+    if (streamer != nullptr) {
+        return streamer->load(path, placeholder);
+    }
+
+    if (auto image = read_current_compressed_image(path)) {
+        gl_texture texture = gl_texture::create();
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint) image->mips.size() - 1);
+        for (int level = 0; level < (int) image->mips.size(); level++) {
+            image->upload_level(level);
+        }
+        return scene.add_texture(std::move(texture));
+    }
+
+    int width, height, channels;
+    unsigned char *image = stbi_load(path.c_str(), &width, &height, &channels, 3);
+
+    gl_texture texture = gl_texture::create();
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexImage2D(
+        GL_TEXTURE_2D, 0, GL_RGB,
+        width, height, 0,
+        GL_RGB, GL_UNSIGNED_BYTE, image
+    );
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    stbi_image_free(image);
+    return scene.add_texture(std::move(texture));
+}
+
+std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, scene_storage& scene, bool with_textures, texture_streamer *streamer) {
     std::ifstream in(path, std::ios_base::in);
     std::string line;
 
@@ -42,9 +83,6 @@ std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool
 
     std::unordered_map<std::string, mtl_items> result;
 
-    unsigned char *image;
-    int width, height, channels;
-
     while (std::getline(in, line)) {
         std::istringstream str(line);
 
@@ -77,6 +115,23 @@ std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool
             continue;
         }
 
+        if (cmd == "d") {
+            float d;
+            str >> d;
+            result[current].opacity = d;
+            result[current].has_dissolve = true;
+            continue;
+        }
+
+        if (cmd == "Tr") {
+            float tr;
+            str >> tr;
+            if (!result[current].has_dissolve) {
+                result[current].opacity = 1.f - tr;
+            }
+            continue;
+        }
+
         if (cmd == "map_Ks") {
             std::string name;
             str >> name;
@@ -88,20 +143,7 @@ std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool
             auto& mtli = result[current];
 
             if (with_textures) {
-                image = stbi_load(img_path.c_str(), &width, &height, &channels, 3);
-
-                glGenTextures(1, &mtli.specular_map);
-                glBindTexture(GL_TEXTURE_2D, mtli.specular_map);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glTexImage2D(
-                    GL_TEXTURE_2D, 0, GL_RGB,
-                    width, height, 0,
-                    GL_RGB, GL_UNSIGNED_BYTE, image
-                );
-                glGenerateMipmap(GL_TEXTURE_2D);
-
-                stbi_image_free(image);
+                mtli.specular_map = load_texture(img_path, scene, streamer, glm::vec3(0.f));
             }
 
             continue;
@@ -118,20 +160,7 @@ std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool
             auto& mtli = result[current];
 
             if (with_textures) {
-                image = stbi_load(img_path.c_str(), &width, &height, &channels, 3);
-
-                glGenTextures(1, &mtli.norm_map);
-                glBindTexture(GL_TEXTURE_2D, mtli.norm_map);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glTexImage2D(
-                    GL_TEXTURE_2D, 0, GL_RGB,
-                    width, height, 0,
-                    GL_RGB, GL_UNSIGNED_BYTE, image
-                );
-                glGenerateMipmap(GL_TEXTURE_2D);
-
-                stbi_image_free(image);
+                mtli.norm_map = load_texture(img_path, scene, streamer, glm::vec3(0.5f, 0.5f, 1.f));
             }
 
             continue;
@@ -148,20 +177,7 @@ std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool
             auto& mtli = result[current];
 
             if (with_textures) {
-                image = stbi_load(img_path.c_str(), &width, &height, &channels, 3);
-
-                glGenTextures(1, &mtli.albedo_texture);
-                glBindTexture(GL_TEXTURE_2D, mtli.albedo_texture);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glTexImage2D(
-                    GL_TEXTURE_2D, 0, GL_RGB,
-                    width, height, 0,
-                    GL_RGB, GL_UNSIGNED_BYTE, image
-                );
-                glGenerateMipmap(GL_TEXTURE_2D);
-
-                stbi_image_free(image);
+                mtli.albedo_texture = load_texture(img_path, scene, streamer, glm::vec3(0.5f));
             }
 
             continue;
@@ -179,20 +195,7 @@ std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool
             auto& mtli = result[current];
 
             if (with_textures) {
-                image = stbi_load(img_path.c_str(), &width, &height, &channels, 3);
-
-                glGenTextures(1, &mtli.mask);
-                glBindTexture(GL_TEXTURE_2D, mtli.mask);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glTexImage2D(
-                    GL_TEXTURE_2D, 0, GL_RGB,
-                    width, height, 0,
-                    GL_RGB, GL_UNSIGNED_BYTE, image
-                );
-                glGenerateMipmap(GL_TEXTURE_2D);
-
-                stbi_image_free(image);
+                mtli.mask = load_texture(img_path, scene, streamer, glm::vec3(0.f));
             }
         }
 
@@ -201,8 +204,9 @@ std::unordered_map<std::string, mtl_items> get_mtl(const std::string& path, bool
     return result;
 }
 
-void parse_scene(const std::string& file, scene_storage& scene, bool with_textures) {
-    stbi_set_flip_vertically_on_load(1);
+void parse_scene(const std::string& file, scene_storage& scene, bool with_textures, texture_streamer *streamer) {
+    // per thread, streamer workers may be decoding with their own flag already
+    stbi_set_flip_vertically_on_load_thread(1);
 
     std::ifstream in(file, std::ios_base::in);
 
@@ -212,12 +216,14 @@ void parse_scene(const std::string& file, scene_storage& scene, bool with_textur
     std::string line;
 
     std::string current;
+    std::string library;
     GLuint albedo_texture = -1;
     GLuint specular_map = -1;
     GLuint norm_map = -1;
     GLuint mask = -1;
     glm::vec3 specular_color = {0.f, 0.f, 0.f};
     float specular_power = 1.f;
+    float opacity = 1.f;
 
     std::vector<glm::vec3> positions;
     std::vector<glm::vec3> normals;
@@ -229,8 +235,8 @@ void parse_scene(const std::string& file, scene_storage& scene, bool with_textur
 
     auto add_object = [&]() {
         if (!indices.empty()) {
-            object obj = object(std::move(vertices), specular_color, specular_power)
-                .with_indices(std::move(indices));
+            object obj(std::move(vertices), specular_color, specular_power);
+            obj.with_indices(std::move(indices));
             if (albedo_texture != (GLuint) -1) {
                 obj.with_albedo_texture(albedo_texture);
             }
@@ -243,6 +249,11 @@ void parse_scene(const std::string& file, scene_storage& scene, bool with_textur
             if (mask != (GLuint) -1) {
                 obj.with_mask(mask);
             }
+            if (opacity < 1.f) {
+                obj.with_blending(opacity);
+            }
+            obj.material_library = library;
+            obj.material = current;
             scene.add_object(std::move(obj));
             indices.clear();
             vertices.clear();
@@ -349,7 +360,8 @@ void parse_scene(const std::string& file, scene_storage& scene, bool with_textur
             std::string path = dir;
             path += "/";
             path += name;
-            mtl = get_mtl(path, with_textures);
+            mtl = get_mtl(path, scene, with_textures, streamer);
+            library = std::filesystem::path(path).lexically_normal().string();
             continue;
         }
 
@@ -363,6 +375,7 @@ void parse_scene(const std::string& file, scene_storage& scene, bool with_textur
             albedo_texture = mtli.albedo_texture;
             norm_map = mtli.norm_map;
             mask = mtli.mask;
+            opacity = mtli.opacity;
             continue;
         }
 
@@ -372,3 +385,35 @@ void parse_scene(const std::string& file, scene_storage& scene, bool with_textur
 
     std::cout << "Parse finished" << std::endl;
 }
+
+void reload_materials(const std::string& file, scene_storage& scene, bool with_textures, texture_streamer *streamer) {
+    std::string library = std::filesystem::path(file).lexically_normal().string();
+    auto mtl = get_mtl(file, scene, with_textures, streamer);
+    scene.apply([&](object& obj) {
+        if (obj.material_library != library) {
+            return;
+        }
+        auto it = mtl.find(obj.material);
+        if (it == mtl.end()) {
+            return;
+        }
+        auto& mtli = it->second;
+        obj.with_specular(mtli.specular_color, mtli.specular_power);
+        if (mtli.albedo_texture != (GLuint) -1) {
+            obj.with_albedo_texture(mtli.albedo_texture);
+        }
+        if (mtli.specular_map != (GLuint) -1) {
+            obj.with_specular_map(mtli.specular_map);
+        }
+        if (mtli.norm_map != (GLuint) -1) {
+            obj.with_norm_map(mtli.norm_map);
+        }
+        if (mtli.mask != (GLuint) -1) {
+            obj.with_mask(mtli.mask);
+        }
+        if (mtli.opacity < 1.f) {
+            obj.with_blending(mtli.opacity);
+        }
+    });
+    std::cout << "Reloaded " << file << std::endl;
+}
@@ -2,5 +2,21 @@
 
 #include "scene_storage.hpp"
 #include "object.hpp"
+#include "texture_streamer.hpp"
 
-void parse_scene(const std::string& file, scene_storage& scene, bool with_textures = true);
+// textures are loaded synchronously unless a streamer is given
+void parse_scene(
+    const std::string& file,
+    scene_storage& scene,
+    bool with_textures = true,
+    texture_streamer *streamer = nullptr
+);
+
+// applies a changed mtl file to the objects parsed with it, textures already loaded
+// from the same paths are shared, maps and blending removed from the file stay until restart
+void reload_materials(
+    const std::string& file,
+    scene_storage& scene,
+    bool with_textures = true,
+    texture_streamer *streamer = nullptr
+);
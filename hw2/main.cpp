@@ -11,11 +11,10 @@
 
 #include <string_view>
 #include <stdexcept>
-#include <sstream>
 #include <iostream>
-#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <vector>
-#include <map>
 
 #define GLM_FORCE_SWIZZLE
 #define GLM_ENABLE_EXPERIMENTAL
@@ -30,88 +29,118 @@
 #include "shader_program.hpp"
 #include "scene_storage.hpp"
 #include "wavefront_parser.hpp"
+#include "texture_streamer.hpp"
+#include "file_watcher.hpp"
+#include "camera_path.hpp"
+#include "frame_statistics.hpp"
+#include "engine/frame_loop.hpp"
+#include "engine/render_target_pool.hpp"
 #include "object_vertex_shader.h"
 #include "object_fragment_shader.h"
+#include "object_geometry_shader.h"
 #include "direction_light_object.hpp"
 #include "shadow_map_builder.hpp"
 #include "cubemap_builder.hpp"
+#include "light_cluster_builder.hpp"
+#include "transparency_builder.hpp"
+#include "deferred_builder.hpp"
+#include "uniform_buffer.hpp"
+#include "frame_uniforms.hpp"
+#ifdef WITH_HEADLESS
+#include "headless.hpp"
+#endif
 
-std::string to_string(std::string_view str) {
-    return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message) {
-    throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error) {
-    throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
+// camera of headless runs at time t: along the nave and back while turning around
+glm::mat4 get_scripted_camera(float t) {
+    glm::mat4 cam_pos(1.f);
+    cam_pos = glm::translate(cam_pos, {100.f * std::sin(0.2f * t), 5.f, 0.f});
+    cam_pos = glm::rotate(cam_pos, 0.5f * t, {0.f, 1.f, 0.f});
+    return cam_pos;
 }
 
-std::pair<glm::vec3, glm::vec3> get_bbox(scene_storage &scene) {
-    glm::vec3 bbox_min(0.f);
-    glm::vec3 bbox_max(0.f);
-
-    scene.apply([&bbox_min, &bbox_max](object &obj) {
-        for (auto v : obj.vertices) {
-
-            auto pos = obj.model * glm::vec4(v.position, 1.f);
-
-            bbox_min.x = std::min(bbox_min.x, pos.x);
-            bbox_min.y = std::min(bbox_min.y, pos.y);
-            bbox_min.z = std::min(bbox_min.z, pos.z);
-
-            bbox_max.x = std::max(bbox_max.x, pos.x);
-            bbox_max.y = std::max(bbox_max.y, pos.y);
-            bbox_max.z = std::max(bbox_max.z, pos.z);
+int main(int argc, char **argv) try {
+    // forward shading unless started with --deferred,
+    // --hot-reload picks up edited shaders, materials and textures while running,
+    // --headless N renders N frames of a scripted camera path without a window
+    // and writes them with their timings to --output,
+    // --record file saves the camera of a live session, --replay file plays it back
+    // at a fixed 60 fps step and prints frame time statistics (N caps its frames when headless),
+    // --shadow-format rg32f|rg16f|rg16 sets the storage of the shadow moments
+    bool use_deferred = false;
+    bool hot_reload = false;
+    int headless_frames = 0;
+    std::filesystem::path output_directory = ".";
+    std::string record_file;
+    std::string replay_file;
+    int width = 1280, height = 720;
+    // GL_RG16 halves the memory and blur bandwidth of GL_RG32F and its rescaled moments
+    // shade within 4 of 255 of it, GL_RG16F lacks the precision and bleeds light in places
+    int shadow_format = GL_RG16;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--deferred") {
+            use_deferred = true;
         }
-    });
-
-    return {bbox_min, bbox_max};
-}
-
-int main() try {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
-        sdl2_fail("SDL_Init: ");
-
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-    SDL_Window *window = SDL_CreateWindow("hw2",
-                                          SDL_WINDOWPOS_CENTERED,
-                                          SDL_WINDOWPOS_CENTERED,
-                                          800, 600,
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-    if (!window)
-        sdl2_fail("SDL_CreateWindow: ");
-
-    int width, height;
-    SDL_GetWindowSize(window, &width, &height);
-
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-    if (!gl_context)
-        sdl2_fail("SDL_GL_CreateContext: ");
+        if (arg == "--hot-reload") {
+            hot_reload = true;
+        }
+        if (arg == "--headless" && i + 1 < argc) {
+            headless_frames = std::stoi(argv[++i]);
+        }
+        if (arg == "--output" && i + 1 < argc) {
+            output_directory = argv[++i];
+        }
+        if (arg == "--record" && i + 1 < argc) {
+            record_file = argv[++i];
+        }
+        if (arg == "--replay" && i + 1 < argc) {
+            replay_file = argv[++i];
+        }
+        if (arg == "--shadow-format" && i + 1 < argc) {
+            std::string_view format = argv[++i];
+            if (format == "rg32f") {
+                shadow_format = GL_RG32F;
+            } else if (format == "rg16f") {
+                shadow_format = GL_RG16F;
+            } else if (format == "rg16") {
+                shadow_format = GL_RG16;
+            } else {
+                throw std::runtime_error("--shadow-format expects rg32f, rg16f or rg16");
+            }
+        }
+        if (arg == "--size" && i + 1 < argc && std::sscanf(argv[++i], "%dx%d", &width, &height) != 2) {
+            throw std::runtime_error("--size expects WIDTHxHEIGHT");
+        }
+    }
+    bool headless = headless_frames > 0;
+
+    // the stencil matches the transparency depth buffer for blitting,
+    // replays measure the frames rather than the display refresh rate
+    render_context context({.title = "hw2", .width = width, .height = height, .stencil_bits = 8,
+                            .swap_interval = replay_file.empty() ? 1 : 0, .headless = headless});
+    width = context.get_width();
+    height = context.get_height();
+    if (headless) {
+        std::filesystem::create_directories(output_directory);
+    }
 
-    if (auto result = glewInit(); result != GLEW_NO_ERROR)
-        glew_fail("glewInit: ", result);
+    file_watcher watcher;
+    if (hot_reload) {
+        shader_program::enable_reloading(PROJECT_SOURCE_DIRECTORY "/shaders");
+        watcher.watch(PROJECT_SOURCE_DIRECTORY "/shaders");
+        watcher.watch(PROJECT_SOURCE_DIRECTORY "/scenes/sponza");
+    }
 
-    if (!GLEW_VERSION_3_3)
-        throw std::runtime_error("OpenGL 3.3 is not supported");
+    // uploads go through texture unit 1, rebound by every textured draw
+    texture_streamer streamer(1);
 
     scene_storage main_scene;
-    parse_scene(PROJECT_SOURCE_DIRECTORY "/scenes/sponza/sponza.obj", main_scene, true);
+    parse_scene(PROJECT_SOURCE_DIRECTORY "/scenes/sponza/sponza.obj", main_scene, true, &streamer);
 
-    main_scene.apply([](object &obj) {
-        obj.model = glm::translate(obj.model, glm::vec3(0.f, -15.f, 0.f));
-        obj.model = glm::scale(obj.model, glm::vec3(0.1f));
-    });
+    glm::mat4 main_model(1.f);
+    main_model = glm::translate(main_model, glm::vec3(0.f, -15.f, 0.f));
+    main_model = glm::scale(main_model, glm::vec3(0.1f));
+    main_scene.set_transform(0, main_model);
 
     scene_storage helmet;
     parse_scene(PROJECT_SOURCE_DIRECTORY "/scenes/helmet/helmet_armet_2.obj", helmet, false);
@@ -124,17 +153,62 @@ int main() try {
 
     glm::vec3 helmet_position = helmet_model * glm::vec4(0.f, 0.f, 0.f, 1.f);
 
-    shader_program main_program(object_vertex_shader_source, object_fragment_shader_source);
+    // headless frames don't depend on how fast the textures decode
+    if (headless) {
+        streamer.wait_decoded();
+    }
 
-    shadow_map_builder shadow(0, 6 * 512);
-    cubemap_builder cubemap(128, true);
+    // specialized per combination of material textures, see scene_storage::draw_nodes
+    shader_program main_program(object_vertex_shader_source, object_fragment_shader_source);
+    main_program.enable_variants();
+    main_program.bind_uniform_block("camera_data", camera_uniforms::binding);
+    main_program.bind_uniform_block("light_data", light_uniforms::binding);
+
+    // renders the helmet environment in one pass with layer selection in a geometry shader
+    bool use_layered_cubemap = true;
+    shader_program cubemap_program(object_vertex_shader_source, object_geometry_shader_source,
+                                   object_fragment_shader_source);
+    cubemap_program.enable_variants();
+    cubemap_program.bind_uniform_block("camera_data", camera_uniforms::binding);
+    cubemap_program.bind_uniform_block("light_data", light_uniforms::binding);
+
+    uniform_buffer<camera_uniforms> camera_buffer(camera_uniforms::binding);
+    uniform_buffer<light_uniforms> light_buffer(light_uniforms::binding);
+
+    // 4 cascades of 1024^2 use less memory and fill than a single 3072^2 map
+    bool use_shadow_cascades = true;
+    float shadow_distance = 300.f;
+    // intermediate textures of the blur passes, reused from frame to frame and across probe sizes
+    render_target_pool render_targets;
+    shadow_map_builder shadow = use_shadow_cascades
+        ? shadow_map_builder(render_targets, 6, 1024, 4, true, shadow_format)
+        : shadow_map_builder(render_targets, 0, 6 * 512, 0, true, shadow_format);
+    cubemap_builder cubemap(render_targets, 128, true);
+    // the sun keeps moving, probe faces are refreshed in the background after it turns this much
+    float probe_light_angle = 0.05f;
+    glm::vec3 probe_light_direction(0.f);
+
+    helmet.set_transform(0, helmet_model);
+
+    // extra helmets along the hall, drawn as instances of the same meshes
+    int helmet_copies = 0;
+    std::vector<int> helmet_nodes = {0};
+    for (int i = 0; i < helmet_copies; i++) {
+        glm::mat4 copy_model(1.f);
+        copy_model = glm::translate(copy_model, {-100.f + 200.f * (i + 0.5f) / helmet_copies, -10.f, 0.f});
+        copy_model = glm::rotate(copy_model, glm::radians(-90.f), {1.f, 0.f, 0.f});
+        copy_model = glm::scale(copy_model, glm::vec3(helmet_scale));
+        helmet_nodes.push_back(helmet.add_node(-1, copy_model));
+    }
 
-    helmet.apply([&helmet_model, &cubemap](object &obj) {
-        obj.model = helmet_model;
+    helmet.apply([&cubemap, &helmet_nodes](object &obj) {
         obj.with_env_map(cubemap.cubemap);
+        if (helmet_nodes.size() > 1) {
+            obj.with_instances(helmet_nodes);
+        }
     });
 
-    auto main_bbox = get_bbox(main_scene);
+    auto main_bbox = main_scene.get_bbox();
 
     float s0 = 5.f;
     float s1 = 15.f;
@@ -156,11 +230,34 @@ int main() try {
         {{48.5f,   -1.5f, -20.0f}, {0.88f * s2, 0.35f * s2, 0.13f * s2}, {0.5f, 0.f, 0.1f}},
     };
 
-    auto last_frame_start = std::chrono::high_resolution_clock::now();
+    light_cluster_builder light_clusters(16, 9, 24, 1.f, 500.f);
 
     float time = 0.f;
 
-    std::map<SDL_Keycode, bool> button_down;
+    // bound to physical keys, so they keep their place on any layout
+    enum action {
+        move_forward, move_back, move_left, move_right, move_up, move_down,
+        look_up, look_down, turn_left, turn_right,
+        // frees the cursor and pauses the camera while held
+        release_cursor,
+        toggle_helmet,
+        quit,
+    };
+    frame_loop loop(context);
+    input_state &input = loop.input;
+    input.bind(move_forward, SDL_SCANCODE_W);
+    input.bind(move_back, SDL_SCANCODE_S);
+    input.bind(move_left, SDL_SCANCODE_A);
+    input.bind(move_right, SDL_SCANCODE_D);
+    input.bind(move_up, SDL_SCANCODE_SPACE);
+    input.bind(move_down, SDL_SCANCODE_LSHIFT);
+    input.bind(look_up, SDL_SCANCODE_UP);
+    input.bind(look_down, SDL_SCANCODE_DOWN);
+    input.bind(turn_left, SDL_SCANCODE_LEFT);
+    input.bind(turn_right, SDL_SCANCODE_RIGHT);
+    input.bind(release_cursor, SDL_SCANCODE_LCTRL);
+    input.bind(toggle_helmet, SDL_SCANCODE_Q);
+    input.bind(quit, SDL_SCANCODE_ESCAPE);
 
     float near = 0.01f;
     float far = 1000.f;
@@ -171,108 +268,143 @@ int main() try {
     glm::mat4 cam_pos(1.f);
     float angle = 0.f;
 
-    glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
+    float fov = glm::pi<float>() / 2.f;
+    glm::mat4 projection = glm::perspective(fov, (1.f * width) / height, near, far);
 
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // blending is enabled only for the transparency pass
+    transparency_builder transparency(12, width, height);
 
-    bool running = true;
-    bool helmet_follow = false;
-    while (running) {
-        float rot_ang = 0.f;
-        bool in_window = false;
-        float d_scale_helmet = 0.f;
-        float d_angle = 0.f;
-        for (SDL_Event event; SDL_PollEvent(&event);)
-            switch (event.type) {
-                case SDL_QUIT:
-                    running = false;
-                    break;
-                case SDL_WINDOWEVENT:
-                    switch (event.window.event) {
-                        case SDL_WINDOWEVENT_RESIZED:
-                            width = event.window.data1;
-                            height = event.window.data2;
-                            glViewport(0, 0, width, height);
-                            projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
-                            break;
-                    }
-                    break;
-                case SDL_KEYDOWN:
-                    if (event.key.keysym.sym == SDLK_ESCAPE) {
-                        running = false;
-                    }
-                    if (event.key.keysym.sym == SDLK_q) {
-                        helmet_follow = !helmet_follow;
-                    }
-                    button_down[event.key.keysym.sym] = true;
-                    break;
-                case SDL_KEYUP:
-                    button_down[event.key.keysym.sym] = false;
-                    break;
-                case SDL_MOUSEMOTION:
-                    d_angle -= mouse_speed * (float) (event.motion.yrel);
-                    rot_ang -= mouse_speed * (float) (event.motion.xrel);
-                    break;
-                case SDL_MOUSEWHEEL:
-                    d_scale_helmet += 0.01f * (float) (event.wheel.y);
-                    break;
-                case SDL_MOUSEBUTTONDOWN:
-                    if (event.button.button == SDL_BUTTON_LEFT) {
-                        helmet_follow = !helmet_follow;
-                    }
-                    break;
-            }
+    // G-buffer on texture units 14 to 17
+    deferred_builder deferred;
+    if (use_deferred) {
+        deferred.init(14, width, height);
+    }
+
+#ifdef WITH_HEADLESS
+    frame_timer timer;
+#endif
+
+    // step of headless runs and replays
+    const float fixed_dt = 1.f / 60.f;
 
-        if (!running)
+    camera_path recording;
+    camera_path replay;
+    bool replaying = !replay_file.empty();
+    if (replaying) {
+        replay.load(replay_file);
+        // the first frame lands on the first recorded one
+        time = replay.get_start_time() - fixed_dt;
+    }
+    std::vector<double> frame_times;
+
+    if (headless || replaying) {
+        // fixed steps keep the frames reproducible
+        loop.set_fixed_step(fixed_dt);
+    }
+    if (replaying && !headless) {
+        loop.on_frame_time = [&](double milliseconds) {
+            frame_times.push_back(milliseconds);
+        };
+    }
+
+    // mouse motion and wheel of the current frame
+    float rot_ang = 0.f;
+    float d_scale_helmet = 0.f;
+    float d_angle = 0.f;
+    loop.on_resize = [&](int new_width, int new_height) {
+        width = new_width;
+        height = new_height;
+        projection = glm::perspective(fov, (1.f * width) / height, near, far);
+        transparency.resize(width, height);
+        if (use_deferred) {
+            deferred.resize(width, height);
+        }
+    };
+    loop.on_event = [&](const SDL_Event &event) {
+        switch (event.type) {
+            case SDL_MOUSEMOTION:
+                d_angle -= mouse_speed * (float) (event.motion.yrel);
+                rot_ang -= mouse_speed * (float) (event.motion.xrel);
+                break;
+            case SDL_MOUSEWHEEL:
+                d_scale_helmet += 0.01f * (float) (event.wheel.y);
+                break;
+        }
+    };
+
+    bool helmet_follow = false;
+    while (loop.next_frame()) {
+        if (input.was_action_pressed(quit)) {
             break;
+        }
+        if (input.was_action_pressed(toggle_helmet) || input.was_button_pressed(SDL_BUTTON_LEFT)) {
+            helmet_follow = !helmet_follow;
+        }
+
+        float dt = loop.get_dt();
 
-        auto now = std::chrono::high_resolution_clock::now();
-        float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-        last_frame_start = now;
+        if (headless) {
+#ifdef WITH_HEADLESS
+            timer.start();
+#endif
+        } else if (!replaying) {
+            std::cout << 1.f / dt << std::endl;
+        }
         time += dt;
-        std::cout << 1.f / dt << std::endl;
 
-        if (!button_down[SDLK_LCTRL]) {
-            if (SDL_GetWindowFlags(window) & SDL_WINDOW_MOUSE_FOCUS) {
+        if (replaying && time > replay.get_end_time()) {
+            break;
+        }
+
+        if (replaying) {
+            auto key = replay.sample(time);
+            cam_pos = key.get_transform();
+            angle = 0.f;
+            d_angle = 0.f;
+            helmet_follow = key.helmet_follow;
+            helmet_scale = key.helmet_scale;
+            d_scale_helmet = 0.f;
+        } else if (headless) {
+            cam_pos = get_scripted_camera(time);
+        } else if (!input.is_action_down(release_cursor)) {
+            if (SDL_GetWindowFlags(context.get_window()) & SDL_WINDOW_MOUSE_FOCUS) {
                 SDL_SetRelativeMouseMode(SDL_TRUE);
                 SDL_ShowCursor(SDL_DISABLE);
-                SDL_WarpMouseInWindow(window, width / 2, height / 2);
+                SDL_WarpMouseInWindow(context.get_window(), width / 2, height / 2);
             }
-            if (button_down[SDLK_UP]) {
+            if (input.is_action_down(look_up)) {
                 angle += 2.f * dt;
             }
-            if (button_down[SDLK_DOWN]) {
+            if (input.is_action_down(look_down)) {
                 angle -= 2.f * dt;
             }
 
-            if (button_down[SDLK_LEFT]) {
+            if (input.is_action_down(turn_left)) {
                 rot_ang += 2.f * dt;
             }
-            if (button_down[SDLK_RIGHT]) {
+            if (input.is_action_down(turn_right)) {
                 rot_ang -= 2.f * dt;
             }
             cam_pos = glm::rotate(cam_pos, rot_ang, {0, 1, 0});
 
             glm::vec3 move_vector(0.f);
 
-            if (button_down[SDLK_w]) {
+            if (input.is_action_down(move_forward)) {
                 move_vector.z -= move_speed * dt;
             }
-            if (button_down[SDLK_s]) {
+            if (input.is_action_down(move_back)) {
                 move_vector.z += move_speed * dt;
             }
-            if (button_down[SDLK_a]) {
+            if (input.is_action_down(move_left)) {
                 move_vector.x -= move_speed * dt;
             }
-            if (button_down[SDLK_d]) {
+            if (input.is_action_down(move_right)) {
                 move_vector.x += move_speed * dt;
             }
-            if (button_down[SDLK_SPACE]) {
+            if (input.is_action_down(move_up)) {
                 move_vector.y += move_speed * dt;
             }
-            if (button_down[SDLK_LSHIFT]) {
+            if (input.is_action_down(move_down)) {
                 move_vector.y -= move_speed * dt;
             }
             cam_pos = glm::translate(cam_pos, move_vector);
@@ -300,45 +432,91 @@ int main() try {
             helmet_model = glm::scale(helmet_model, glm::vec3(helmet_scale));
             helmet_position = helmet_model * glm::vec4(0.f, 0.f, 0.f, 1.f);
 
-            helmet.apply([&helmet_model](object &obj) {
-                obj.model = helmet_model;
-            });
+            helmet.set_transform(0, helmet_model);
         }
 
-        shadow.draw({&main_scene, &helmet}, main_bbox, direction_light);
+        if (!record_file.empty()) {
+            recording.add(time, cam_pos_upd, helmet_scale, helmet_follow);
+        }
 
-        glClearColor(0.8f, 0.6f, 0.4f, 1.f);
+        glm::mat4 view = glm::inverse(cam_pos_upd);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, shadow.shadow_map);
+        light_uniforms light_data{};
+        light_data.rescaled_moments = shadow.rescaled_moments();
 
-        glm::mat4 transform = direction_light.get_transform(main_bbox);
+        if (use_shadow_cascades) {
+            // sponza is static, cascades the camera didn't leave only redraw the helmet
+            shadow.draw_cascades_cached({&main_scene}, {&helmet}, main_bbox, direction_light,
+                                        view, fov, (1.f * width) / height, near, shadow_distance);
 
-        main_program.bind();
+            glActiveTexture(GL_TEXTURE6);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, shadow.shadow_map);
+
+            light_data.cascade_number = (int) shadow.cascade_transforms.size();
+            std::copy(shadow.cascade_transforms.begin(), shadow.cascade_transforms.end(), light_data.cascade_transforms);
+        } else {
+            // sponza is static, only the helmet is redrawn every frame
+            shadow.draw_cached({&main_scene}, {&helmet}, main_bbox, direction_light);
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, shadow.shadow_map);
+
+            light_data.transform = shadow.transform;
+        }
 
-        glUniform3f(main_program["ambient"], 0.3f, 0.3f, 0.3f);
+        glClearColor(0.8f, 0.6f, 0.4f, 1.f);
 
-        glUniform3fv(main_program["light_direction"], 1, reinterpret_cast<float *>(&direction_light.direction));
-        glUniform3fv(main_program["light_color"], 1, reinterpret_cast<float *>(&direction_light.light));
+        light_data.ambient = glm::vec3(0.3f);
+        light_data.light_direction = direction_light.direction;
+        light_data.light_color = direction_light.light;
+        light_buffer.update(light_data);
+
+        light_clusters.build(point_lights, view, projection);
+
+        for (auto& file : watcher.poll()) {
+            if (file.extension() == ".glsl") {
+                shader_program::notify_changed(file);
+            } else if (file.extension() == ".mtl") {
+                reload_materials(file.string(), main_scene, true, &streamer);
+                // masks and blending may have changed for the cached casters
+                shadow.invalidate();
+            } else {
+                streamer.reload(file.string());
+            }
+        }
 
-        glUniform1i(main_program["shadow_map"], 0);
-        glUniformMatrix4fv(main_program["transform"], 1, GL_FALSE, reinterpret_cast<float *>(&transform));
+        main_scene.request_textures(streamer, view, projection, (float) height);
+        streamer.update();
 
-        glUniform1i(main_program["point_light_number"], point_lights.size());
+        std::vector<shader_program *> lit_programs = {&main_program, &cubemap_program};
+        if (use_deferred) {
+            lit_programs.push_back(&deferred.directional_program);
+            lit_programs.push_back(&deferred.point_program);
+        }
+        for (shader_program *program : lit_programs) {
+            program->bind();
+            program->set("shadow_map", 0);
+            program->set("shadow_cascades", 6);
+            light_clusters.bind(*program, 8, false);
+        }
 
-        for (int i = 0; i < point_lights.size(); i++) {
-            std::stringstream name;
-            name << "point_light_color[" << i << "]";
-            glUniform3fv(main_program[name.str()], 1, reinterpret_cast<float *>(&point_lights[i].light));
-            name.str("");
-            name << "point_light_attenuation[" << i << "]";
-            glUniform3fv(main_program[name.str()], 1, reinterpret_cast<float *>(&point_lights[i].attenuation));
-            name.str("");
-            name << "point_light_position[" << i << "]";
-            glUniform3fv(main_program[name.str()], 1, reinterpret_cast<float *>(&point_lights[i].position));
+        if (glm::dot(direction_light.direction, probe_light_direction) < std::cos(probe_light_angle)) {
+            probe_light_direction = direction_light.direction;
+            cubemap.invalidate();
         }
 
-        cubemap.draw(helmet_position, {&main_scene}, main_program, near, far);
+        // projected diameter of the helmet in pixels
+        auto [helmet_min, helmet_max] = helmet.get_bbox();
+        float helmet_distance = glm::distance(glm::vec3(cam_pos_upd[3]), helmet_position);
+        float helmet_screen_size = glm::distance(helmet_min, helmet_max)
+            / (std::max(helmet_distance, near) * std::tan(fov / 2.f)) * 0.5f * height;
+
+        int face_mask = cubemap.schedule(helmet_position, helmet_screen_size);
+        if (use_layered_cubemap) {
+            cubemap.draw_layered(helmet_position, {&main_scene}, cubemap_program, camera_buffer, near, far, face_mask);
+        } else {
+            cubemap.draw(helmet_position, {&main_scene}, main_program, camera_buffer, near, far, face_mask);
+        }
 
         main_program.bind();
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
@@ -351,17 +529,65 @@ int main() try {
         glEnable(GL_CULL_FACE);
         glCullFace(GL_BACK);
 
-        glm::mat4 view = glm::inverse(cam_pos_upd);
-        glUniformMatrix4fv(main_program["view"], 1, GL_FALSE, reinterpret_cast<float *>(&view));
-        glUniformMatrix4fv(main_program["projection"], 1, GL_FALSE, reinterpret_cast<float *>(&projection));
+        main_program.set("use_light_clusters", true);
+
+        camera_uniforms camera_data{};
+        camera_data.view = view;
+        camera_data.projection = projection;
+        camera_data.camera_position = cam_pos_upd[3];
+        camera_buffer.update(camera_data);
+
+        if (use_deferred) {
+            deferred.begin();
+            main_scene.draw_objects(deferred.geometry_program);
+            helmet.draw_objects(deferred.geometry_program);
+            deferred.end(view, projection, (int) point_lights.size(), far);
+            main_program.bind();
+        } else {
+            main_scene.draw_objects(main_program);
+            helmet.draw_objects(main_program);
+        }
+
+        if (main_scene.has_transparent() || helmet.has_transparent()) {
+            transparency.begin();
+            main_scene.draw_transparent(main_program);
+            helmet.draw_transparent(main_program);
+            transparency.end();
+        }
+
+        if (headless) {
+#ifdef WITH_HEADLESS
+            frame_times.push_back(timer.stop());
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%04d.png", loop.get_frame());
+            // builders leave their framebuffers bound for reading
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+            write_png((output_directory / name).string(), width, height);
+#endif
+            if (loop.get_frame() + 1 == headless_frames) {
+                loop.stop();
+            }
+        }
+
+        rot_ang = 0.f;
+        d_scale_helmet = 0.f;
+        d_angle = 0.f;
+        render_targets.end_frame();
+        loop.end_frame();
+    }
 
-        main_scene.draw_objects(main_program);
-        helmet.draw_objects(main_program);
+    if (!record_file.empty()) {
+        recording.save(record_file);
+    }
+    if (headless || replaying) {
+        std::cout << get_frame_statistics(frame_times) << std::endl;
+    }
 
-        SDL_GL_SwapWindow(window);
+#ifdef WITH_HEADLESS
+    if (headless) {
+        timer.write_csv((output_directory / "timings.csv").string());
     }
-    SDL_GL_DeleteContext(gl_context);
-    SDL_DestroyWindow(window);
+#endif
 }
 catch (std::exception const &e) {
     std::cerr << e.what() << std::endl;
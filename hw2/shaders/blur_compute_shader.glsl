@@ -0,0 +1,65 @@
+#version 330 core
+#extension GL_ARB_compute_shader : require
+#extension GL_ARB_shader_image_load_store : require
+
+#define TILE_SIZE 128
+#define MAX_N 15
+
+layout (local_size_x = TILE_SIZE) in;
+
+uniform sampler2D target;
+
+// FEATURES picks the format of result, it has to match the bound image;
+// the program without variants is never dispatched
+#ifndef FEATURES
+#define FEATURES 0
+#endif
+#if FEATURES == 1
+layout (rg16f) uniform writeonly image2D result;
+#elif FEATURES == 2
+layout (rg16) uniform writeonly image2D result;
+#elif FEATURES == 3
+layout (rgba8) uniform writeonly image2D result;
+#else
+layout (rg32f) uniform writeonly image2D result;
+#endif
+
+uniform int mode;
+uniform int N;
+// weights[i] of taps -i and i, normalized
+uniform float weights[MAX_N + 1];
+// (x0, y0, x1, y1) of written texels
+uniform ivec4 region;
+
+shared vec4 tile[TILE_SIZE + 2 * MAX_N];
+
+void main()
+{
+    ivec2 axis = mode == 1 ? ivec2(1, 0) : ivec2(0, 1);
+    ivec2 across = ivec2(1, 1) - axis;
+    int size = textureSize(target, 0)[mode == 1 ? 0 : 1];
+
+    int line = int(gl_WorkGroupID.y) + region[mode == 1 ? 1 : 0];
+    int start = int(gl_WorkGroupID.x) * TILE_SIZE + region[mode == 1 ? 0 : 1];
+    int end = region[mode == 1 ? 2 : 3];
+    int local = int(gl_LocalInvocationID.x);
+
+    for (int i = local; i < TILE_SIZE + 2 * N; i += TILE_SIZE) {
+        int p = clamp(start + i - N, 0, size - 1);
+        tile[i] = texelFetch(target, axis * p + across * line, 0);
+    }
+
+    barrier();
+
+    int p = start + local;
+    if (p >= end) {
+        return;
+    }
+
+    vec4 sum = weights[0] * tile[local + N];
+    for (int i = 1; i <= N; i++) {
+        sum += weights[i] * (tile[local + N - i] + tile[local + N + i]);
+    }
+
+    imageStore(result, axis * p + across * line, sum);
+}
@@ -1,9 +1,13 @@
 #version 330 core
 
+#define MAX_TAPS 9
+
 uniform sampler2D target;
 uniform int mode;
-uniform int N;
-uniform float radius;
+uniform int taps;
+// taps i and i + 1 folded into one linear sample at offsets[k] with weights[k]
+uniform float weights[MAX_TAPS];
+uniform float offsets[MAX_TAPS];
 
 in vec2 texcoord;
 
@@ -15,15 +19,13 @@ void main()
     if (mode == 1) {
         dir = vec2(1.0, 0.0);
     }
+    dir /= vec2(textureSize(target, 0));
 
-    vec4 sum = vec4(0.0);
-    float sum_w = 0.0;
-    for (int i = -N; i <= N; i++) {
-        float w = exp(-i*i / (radius*radius));
-        vec2 vector = i * dir / vec2(textureSize(target, 0));
-        sum += w * texture(target, texcoord + vector);
-        sum_w += w;
+    vec4 sum = weights[0] * texture(target, texcoord);
+    for (int k = 1; k < taps; k++) {
+        vec2 vector = offsets[k] * dir;
+        sum += weights[k] * (texture(target, texcoord + vector) + texture(target, texcoord - vector));
     }
 
-    out_color = sum / sum_w;
+    out_color = sum;
 }
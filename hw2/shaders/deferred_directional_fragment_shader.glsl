@@ -0,0 +1,45 @@
+#version 330 core
+
+uniform sampler2D gbuffer_albedo;
+uniform sampler2D gbuffer_normal;
+uniform sampler2D gbuffer_specular;
+uniform sampler2D gbuffer_depth;
+
+uniform mat4 inverse_view_projection;
+
+#include "include/camera_data.glsl"
+#include "include/shadow.glsl"
+#include "include/normal_encoding.glsl"
+
+in vec2 texcoord;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gbuffer_depth, pixel, 0).x;
+    if (depth == 1.0) {
+        // background, left to the resolve pass
+        discard;
+    }
+    vec4 world_position = inverse_view_projection * vec4(vec3(texcoord, depth) * 2.0 - 1.0, 1.0);
+    vec3 position = world_position.xyz / world_position.w;
+
+    vec4 albedo_data = texelFetch(gbuffer_albedo, pixel, 0);
+    vec4 normal_data = texelFetch(gbuffer_normal, pixel, 0);
+    vec4 specular_data = texelFetch(gbuffer_specular, pixel, 0);
+
+    vec3 albedo = albedo_data.rgb;
+    vec3 normal_vec = decode_normal(normal_data.xy);
+    vec3 normal = decode_normal(normal_data.zw);
+    vec3 specular_color = specular_data.rgb;
+    float specular_power = exp2(specular_data.a * 12.0) - 1.0;
+
+    vec3 cam_direction = normalize(camera_position - position);
+
+    float shadow_factor = albedo_data.a > 0.5 ? get_shadow(position) : 1.0;
+    vec3 color = directional_light(normal, normal_vec, cam_direction, albedo, specular_color, specular_power, shadow_factor);
+
+    out_color = vec4(color, 1.0);
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+uniform sampler2D gbuffer_albedo;
+uniform sampler2D gbuffer_normal;
+uniform sampler2D gbuffer_specular;
+uniform sampler2D gbuffer_depth;
+
+uniform mat4 inverse_view_projection;
+uniform vec2 viewport_size;
+
+#include "include/camera_data.glsl"
+#include "include/point_light.glsl"
+#include "include/normal_encoding.glsl"
+
+flat in int light_index;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gbuffer_depth, pixel, 0).x;
+    if (depth == 1.0) {
+        discard;
+    }
+    vec4 world_position = inverse_view_projection * vec4(vec3(gl_FragCoord.xy / viewport_size, depth) * 2.0 - 1.0, 1.0);
+    vec3 position = world_position.xyz / world_position.w;
+
+    // pixels outside the light volume or facing away are skipped before reading the whole G-buffer
+    vec4 position_radius = texelFetch(point_light_data, 3 * light_index);
+    vec3 point_light_vector = position_radius.xyz - position;
+    if (dot(point_light_vector, point_light_vector) > position_radius.w * position_radius.w) {
+        discard;
+    }
+
+    vec4 normal_data = texelFetch(gbuffer_normal, pixel, 0);
+    vec3 normal = decode_normal(normal_data.zw);
+    if (dot(normal, point_light_vector) < 0.0) {
+        discard;
+    }
+    vec3 normal_vec = decode_normal(normal_data.xy);
+    vec3 albedo = texelFetch(gbuffer_albedo, pixel, 0).rgb;
+    vec4 specular_data = texelFetch(gbuffer_specular, pixel, 0);
+    vec3 specular_color = specular_data.rgb;
+    float specular_power = exp2(specular_data.a * 12.0) - 1.0;
+
+    vec3 cam_direction = normalize(camera_position - position);
+
+    vec3 color = point_light(light_index, position, normal, normal_vec, cam_direction, albedo, specular_color, specular_power);
+    out_color = vec4(color, 0.0);
+}
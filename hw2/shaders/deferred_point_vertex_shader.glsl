@@ -0,0 +1,25 @@
+#version 330 core
+
+layout (std140) uniform camera_data {
+    mat4 view;
+    mat4 projection;
+    vec3 camera_position;
+};
+
+// 3 texels per light: (position, radius), (color, 0), (attenuation, 0)
+uniform samplerBuffer point_light_data;
+// volumes of unbounded lights only have to cover the visible scene
+uniform float max_light_distance;
+
+// unit sphere, slightly enlarged to contain the exact one
+layout (location = 0) in vec3 in_position;
+
+flat out int light_index;
+
+void main()
+{
+    vec4 position_radius = texelFetch(point_light_data, 3 * gl_InstanceID);
+    float radius = min(position_radius.w, distance(position_radius.xyz, camera_position) + max_light_distance);
+    gl_Position = projection * view * vec4(position_radius.xyz + radius * in_position, 1.0);
+    light_index = gl_InstanceID;
+}
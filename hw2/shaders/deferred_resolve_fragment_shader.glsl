@@ -0,0 +1,19 @@
+#version 330 core
+
+uniform sampler2D light_accumulation;
+uniform sampler2D gbuffer_depth;
+
+in vec2 texcoord;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    if (texelFetch(gbuffer_depth, pixel, 0).x == 1.0) {
+        // keeps the clear color of the target
+        discard;
+    }
+    vec3 color = texelFetch(light_accumulation, pixel, 0).rgb;
+    out_color = vec4(color / (1.0 + color), 1.0);
+}
@@ -0,0 +1,75 @@
+#version 330 core
+
+// a program variant fixes the mask, unused branches and fetches are compiled out
+#ifdef FEATURES
+const int textures_mask = FEATURES;
+#else
+uniform int textures_mask;
+#endif
+
+uniform sampler2D albedo_texture; // 1 << 1
+uniform sampler2D specular_map; // 1 << 2
+uniform sampler2D norm_map; // 1 << 3
+uniform sampler2D mask; // 1 << 4
+uniform samplerCube env_map; // 1 << 5
+
+// 0 opaque, 1 alpha tested against mask
+uniform int alpha_mode;
+uniform float opacity;
+
+uniform float specular_power;
+uniform vec3 specular_color;
+
+#include "include/camera_data.glsl"
+#include "include/normal_encoding.glsl"
+
+in vertex_data {
+    vec3 position;
+    vec2 texcoord;
+    mat3 tbn;
+};
+
+// albedo, shadow receiver flag
+layout (location = 0) out vec4 out_albedo;
+// octahedral shading normal, octahedral geometric normal
+layout (location = 1) out vec4 out_normal;
+// specular color scaled by the specular map, log encoded specular power
+layout (location = 2) out vec4 out_specular;
+
+void main()
+{
+    bool use_shadow = (textures_mask & (1 << 0)) != 0;
+    bool use_albedo = (textures_mask & (1 << 1)) != 0;
+    bool use_specular = (textures_mask & (1 << 2)) != 0;
+    bool use_norm = (textures_mask & (1 << 3)) != 0;
+    bool use_mask = (textures_mask & (1 << 4)) != 0;
+    bool use_env = (textures_mask & (1 << 5)) != 0;
+
+    float alpha = opacity * (use_mask ? texture(mask, texcoord).x : 1.0);
+    if (alpha_mode == 1 && alpha < 0.5) {
+        discard;
+    }
+
+    vec3 normal_vec = vec3(0.0, 0.0, 1.0);
+    if (use_norm) {
+        vec2 normal_xy = 2 * texture(norm_map, texcoord).xy - 1;
+        normal_vec = vec3(normal_xy, sqrt(max(0.0, 1.0 - dot(normal_xy, normal_xy))));
+    }
+    normal_vec = normalize(tbn * normal_vec);
+    vec3 normal = normalize(tbn * vec3(0.0, 0.0, 1.0));
+
+    float specular_factor = use_specular ? texture(specular_map, texcoord).x : 1.0;
+
+    vec3 albedo = use_albedo ? texture(albedo_texture, texcoord).rgb : vec3(1.0, 1.0, 1.0);
+
+    if (use_env) {
+        vec3 cam_direction = normalize(camera_position - position);
+        float cosine = dot(normal_vec, cam_direction);
+        vec3 reflected = 2.0 * normal_vec * cosine - cam_direction;
+        albedo = texture(env_map, -normalize(reflected)).rgb;
+    }
+
+    out_albedo = vec4(albedo, use_shadow ? 1.0 : 0.0);
+    out_normal = vec4(encode_normal(normal_vec), encode_normal(normal));
+    out_specular = vec4(specular_color * specular_factor, log2(specular_power + 1.0) / 12.0);
+}
@@ -0,0 +1,5 @@
+layout (std140) uniform camera_data {
+    mat4 view;
+    mat4 projection;
+    vec3 camera_position;
+};
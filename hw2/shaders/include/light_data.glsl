@@ -0,0 +1,9 @@
+layout (std140) uniform light_data {
+    mat4 transform;
+    vec3 ambient;
+    vec3 light_direction;
+    vec3 light_color;
+    mat4 cascade_transforms[4];
+    int cascade_number;
+    bool rescaled_moments;
+};
@@ -0,0 +1,37 @@
+// 3 texels per light: (position, radius), (color, 0), (attenuation, 0)
+uniform samplerBuffer point_light_data;
+
+vec3 point_light(int i, vec3 position, vec3 normal, vec3 normal_vec, vec3 cam_direction, vec3 albedo,
+    vec3 specular_color, float specular_power)
+{
+    vec4 position_radius = texelFetch(point_light_data, 3 * i);
+    vec3 point_light_color = texelFetch(point_light_data, 3 * i + 1).rgb;
+    vec3 point_light_attenuation = texelFetch(point_light_data, 3 * i + 2).rgb;
+
+    vec3 point_light_vector = position_radius.xyz - position;
+    vec3 point_light_direction = normalize(point_light_vector);
+    if (dot(normal, point_light_direction) < 0.0) {
+        return vec3(0.0);
+    }
+    float point_light_distance = length(point_light_vector);
+
+    // fade out to zero at the culling radius so cluster borders are not visible,
+    // only over its last 15%, where the light is near the threshold already
+    float window = 1.0 - smoothstep(0.85 * position_radius.w, position_radius.w, point_light_distance);
+
+    float point_light_cosine = dot(normal_vec, point_light_direction);
+    float point_light_factor = max(0.0, point_light_cosine);
+    float point_light_intensity = 1.0 / dot(point_light_attenuation,
+        vec3(1.0, point_light_distance, point_light_distance * point_light_distance));
+
+    vec3 color = albedo * point_light_color * point_light_factor * point_light_intensity;
+
+    vec3 point_reflected = 2.0 * normal_vec * point_light_cosine - point_light_direction;
+    float point_specular = pow(max(0.0, dot(point_reflected, cam_direction)), specular_power);
+
+    float specular_intensity = 1.0 / dot(vec2(1.0, 0.1),
+        vec2(1.0, point_light_distance));
+    color += specular_intensity * point_light_color * specular_color * point_specular;
+
+    return window * color;
+}
@@ -0,0 +1,78 @@
+#include "light_data.glsl"
+
+uniform sampler2D shadow_map;
+uniform sampler2DArray shadow_cascades; // if cascade_number > 0
+
+vec3 get_shadow_position(mat4 shadow_transform, vec3 position)
+{
+    vec4 shadow_pos = shadow_transform * vec4(position, 1.0);
+    shadow_pos /= shadow_pos.w;
+    return shadow_pos.xyz * 0.5 + vec3(0.5);
+}
+
+bool in_shadow_texture(vec3 shadow_pos)
+{
+    return
+        (shadow_pos.x > 0.0) && (shadow_pos.x < 1.0) &&
+        (shadow_pos.y > 0.0) && (shadow_pos.y < 1.0) &&
+        (shadow_pos.z > 0.0) && (shadow_pos.z < 1.0);
+}
+
+float get_shadow_factor(vec2 data, float z)
+{
+    if (rescaled_moments) {
+        data.y = 0.25 * (data.y - 1.0) + data.x;
+    }
+    float mu = data.x;
+    float sigma = max(data.y - mu * mu, 0.0);
+    z -= 0.001;
+    if (z < mu) {
+        return 1.0;
+    }
+    float shadow_factor = sigma / (sigma + (z - mu) * (z - mu));
+    float delta = 0.6;
+    if (shadow_factor < delta) {
+        return 0.0;
+    }
+    return (shadow_factor - delta) / (1.0 - delta);
+}
+
+// first cascade containing the position, the single shadow map without cascades
+float get_shadow(vec3 position)
+{
+    if (cascade_number > 0) {
+        for (int i = 0; i < cascade_number; i++) {
+            vec3 shadow_pos = get_shadow_position(cascade_transforms[i], position);
+            if (in_shadow_texture(shadow_pos)) {
+                return get_shadow_factor(texture(shadow_cascades, vec3(shadow_pos.xy, i)).rg, shadow_pos.z);
+            }
+        }
+    } else {
+        vec3 shadow_pos = get_shadow_position(transform, position);
+        if (in_shadow_texture(shadow_pos)) {
+            return get_shadow_factor(texture(shadow_map, shadow_pos.xy).rg, shadow_pos.z);
+        }
+    }
+    return 1.0;
+}
+
+// ambient, diffuse and specular of the directional light
+vec3 directional_light(vec3 normal, vec3 normal_vec, vec3 cam_direction, vec3 albedo,
+    vec3 specular_color, float specular_power, float shadow_factor)
+{
+    vec3 light = ambient;
+
+    if (dot(normal, light_direction) < 0.0) {
+        shadow_factor = 0.0;
+    }
+
+    light += light_color * max(0.0, dot(normal_vec, light_direction)) * shadow_factor;
+    vec3 color = albedo * light;
+
+    float light_cosine = dot(normal_vec, light_direction);
+    vec3 light_reflected = 2.0 * normal_vec * light_cosine - light_direction;
+    float specular = pow(max(0.0, dot(light_reflected, cam_direction)), specular_power);
+    color += shadow_factor * specular_color * specular;
+
+    return color;
+}
@@ -1,35 +1,65 @@
 #version 330 core
 
+// a program variant fixes the mask, unused branches and fetches are compiled out
+#ifdef FEATURES
+const int textures_mask = FEATURES;
+#else
 uniform int textures_mask;
+#endif
 
-uniform sampler2D shadow_map; // 1 << 0
+// shadow_map and shadow_cascades: 1 << 0
 uniform sampler2D albedo_texture; // 1 << 1
 uniform sampler2D specular_map; // 1 << 2
 uniform sampler2D norm_map; // 1 << 3
 uniform sampler2D mask; // 1 << 4
 uniform samplerCube env_map; // 1 << 5
 
-uniform vec3 ambient;
+// 0 opaque, 1 alpha tested against mask, 2 weighted blended transparency
+uniform int alpha_mode;
+uniform float opacity;
 
 uniform float specular_power;
 uniform vec3 specular_color;
 
-uniform vec3 light_direction;
-uniform vec3 light_color;
-
-uniform mat4 transform;
+#include "include/camera_data.glsl"
+#include "include/shadow.glsl"
+#include "include/point_light.glsl"
 
 uniform int point_light_number;
-uniform vec3 point_light_color[32];
-uniform vec3 point_light_attenuation[32];
-uniform vec3 point_light_position[32];
 
-in vec3 position;
-in vec2 texcoord;
-in vec3 cam_position;
-in mat3 tbn;
+// (offset, count) into light_index_data per cluster
+uniform usamplerBuffer light_cluster_data;
+uniform usamplerBuffer light_index_data;
+uniform bool use_light_clusters;
+uniform ivec3 light_cluster_grid;
+uniform vec2 light_cluster_depth;
+
+in vertex_data {
+    vec3 position;
+    vec2 texcoord;
+    mat3 tbn;
+};
 
 layout (location = 0) out vec4 out_color;
+// sum of alpha weights for blended transparency
+layout (location = 1) out vec4 out_weight;
+
+int get_light_cluster()
+{
+    vec4 view_position = view * vec4(position, 1.0);
+    vec4 clip_position = projection * view_position;
+    vec2 ndc = clip_position.xy / clip_position.w;
+
+    ivec2 tile = clamp(ivec2(floor((ndc * 0.5 + 0.5) * vec2(light_cluster_grid.xy))),
+        ivec2(0), light_cluster_grid.xy - 1);
+
+    float depth = max(-view_position.z, 1e-6);
+    int slice = int(floor(log(depth / light_cluster_depth.x) / log(light_cluster_depth.y / light_cluster_depth.x)
+        * float(light_cluster_grid.z)));
+    slice = clamp(slice, 0, light_cluster_grid.z - 1);
+
+    return (slice * light_cluster_grid.y + tile.y) * light_cluster_grid.x + tile.x;
+}
 
 void main()
 {
@@ -40,43 +70,25 @@ void main()
     bool use_mask = (textures_mask & (1 << 4)) != 0;
     bool use_env = (textures_mask & (1 << 5)) != 0;
 
-    vec3 normal_vec = use_norm ? normalize(2 * texture(norm_map, texcoord).xyz - 1) : vec3(0.0, 0.0, 1.0);
+    float alpha = opacity * (use_mask ? texture(mask, texcoord).x : 1.0);
+    if (alpha_mode == 1 && alpha < 0.5) {
+        discard;
+    }
+
+    vec3 normal_vec = vec3(0.0, 0.0, 1.0);
+    if (use_norm) {
+        // z is reconstructed, two channel compressed maps only store x and y
+        vec2 normal_xy = 2 * texture(norm_map, texcoord).xy - 1;
+        normal_vec = vec3(normal_xy, sqrt(max(0.0, 1.0 - dot(normal_xy, normal_xy))));
+    }
     normal_vec = normalize(tbn * normal_vec);
     vec3 normal = normalize(tbn * vec3(0.0, 0.0, 1.0));
 
-    vec3 cam_direction = normalize(cam_position - position);
+    vec3 cam_direction = normalize(camera_position - position);
 
     float specular_factor = use_specular ? texture(specular_map, texcoord).x : 1.0;
 
-    float shadow_factor = 1.0;
-    if (use_shadow) {
-        vec4 shadow_pos = transform * vec4(position, 1.0);
-        shadow_pos /= shadow_pos.w;
-        shadow_pos = shadow_pos * 0.5 + vec4(0.5);
-
-        bool in_shadow_texture =
-            (shadow_pos.x > 0.0) && (shadow_pos.x < 1.0) &&
-            (shadow_pos.y > 0.0) && (shadow_pos.y < 1.0) &&
-            (shadow_pos.z > 0.0) && (shadow_pos.z < 1.0);
-        if (in_shadow_texture) {
-            vec2 data = texture(shadow_map, shadow_pos.xy).rg;
-            float mu = data.x;
-            float sigma = data.y - mu * mu;
-            float z = shadow_pos.z;
-            z -= 0.001;
-            if (z < mu) {
-                shadow_factor = 1.0;
-            } else {
-                shadow_factor = sigma / (sigma + (z - mu) * (z - mu));
-                float delta = 0.6;
-                if (shadow_factor < delta) {
-                    shadow_factor = 0.0;
-                } else {
-                    shadow_factor = (shadow_factor - delta) / (1.0 - delta);
-                }
-            }
-        }
-    }
+    float shadow_factor = use_shadow ? get_shadow(position) : 1.0;
     vec3 albedo = use_albedo ? texture(albedo_texture, texcoord).rgb : vec3(1.0, 1.0, 1.0);
 
     if (use_env) {
@@ -86,45 +98,31 @@ void main()
         albedo = env_factor * texture(env_map, -normalize(reflected)).rgb + (1 - env_factor) * albedo;
     }
 
-    vec3 light = ambient;
-
-    if (dot(normal, light_direction) < 0.0) {
-        shadow_factor = 0.0;
-    }
-
-    light += light_color * max(0.0, dot(normal_vec, light_direction)) * shadow_factor;
-    vec3 color = albedo * light;
-
-    float light_cosine = dot(normal_vec, light_direction);
-    vec3 light_reflected = 2.0 * normal_vec * light_cosine - light_direction;
-    float specular = pow(max(0.0, dot(light_reflected, cam_direction)), specular_power) * specular_factor;
-    color += shadow_factor * specular_color * specular;
+    vec3 specular = specular_color * specular_factor;
+    vec3 color = directional_light(normal, normal_vec, cam_direction, albedo, specular, specular_power, shadow_factor);
 
-    for (int i = 0; i < point_light_number; i++) {
-        vec3 point_light_vector = point_light_position[i] - position;
-        vec3 point_light_direction = normalize(point_light_vector);
-        if (dot(normal, point_light_direction) < 0.0) {
-            continue;
+    if (use_light_clusters) {
+        uvec2 cluster = texelFetch(light_cluster_data, get_light_cluster()).xy;
+        for (uint k = 0u; k < cluster.y; k++) {
+            int i = int(texelFetch(light_index_data, int(cluster.x + k)).x);
+            color += point_light(i, position, normal, normal_vec, cam_direction, albedo, specular, specular_power);
+        }
+    } else {
+        for (int i = 0; i < point_light_number; i++) {
+            color += point_light(i, position, normal, normal_vec, cam_direction, albedo, specular, specular_power);
         }
-        float point_light_cosine = dot(normal_vec, point_light_direction);
-        float point_light_factor = max(0.0, point_light_cosine);
-        float point_light_distance = length(point_light_vector);
-        float point_light_intensity = 1.0 / dot(point_light_attenuation[i],
-            vec3(1.0, point_light_distance, point_light_distance * point_light_distance));
-
-        color += albedo * point_light_color[i] * point_light_factor * point_light_intensity;
-
-        vec3 point_reflected = 2.0 * normal_vec * point_light_cosine - point_light_direction;
-        float point_specular = pow(max(0.0, dot(point_reflected, cam_direction)), specular_power) * specular_factor;
-
-        float specular_intensity = 1.0 / dot(vec2(1.0, 0.1),
-            vec2(1.0, point_light_distance));
-        color += specular_intensity * point_light_color[i] * specular_color * point_specular;
     }
 
     color = color / (1.0 + color);
 
-    float alpha = use_mask ? texture(mask, texcoord).x : 1.0;
-
-    out_color = vec4(color, alpha);
+    if (alpha_mode == 2) {
+        // accumulated color and weight, alpha is multiplied into the revealage
+        float z = gl_FragCoord.z;
+        float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - z * 0.9, 3.0), 1e-2, 3e3);
+        out_color = vec4(color * alpha * weight, alpha);
+        out_weight = vec4(alpha * weight, 0.0, 0.0, 0.0);
+    } else {
+        out_color = vec4(color, 1.0);
+        out_weight = vec4(0.0);
+    }
 }
@@ -0,0 +1,59 @@
+#version 330 core
+
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 18) out;
+
+// projection * view of each cubemap face
+uniform mat4 face_transforms[6];
+// faces the object is visible in
+uniform int face_mask;
+
+in vertex_data {
+    vec3 position;
+    vec2 texcoord;
+    mat3 tbn;
+} vertices[];
+
+out vertex_data {
+    vec3 position;
+    vec2 texcoord;
+    mat3 tbn;
+};
+
+bool is_outside(vec4 a, vec4 b, vec4 c)
+{
+    vec3 w = vec3(a.w, b.w, c.w);
+    vec3 x = vec3(a.x, b.x, c.x);
+    vec3 y = vec3(a.y, b.y, c.y);
+    vec3 z = vec3(a.z, b.z, c.z);
+    return all(lessThan(x, -w)) || all(greaterThan(x, w))
+        || all(lessThan(y, -w)) || all(greaterThan(y, w))
+        || all(lessThan(z, -w)) || all(greaterThan(z, w));
+}
+
+void main()
+{
+    for (int face = 0; face < 6; face++) {
+        if ((face_mask & (1 << face)) == 0) {
+            continue;
+        }
+
+        vec4 clip[3];
+        for (int i = 0; i < 3; i++) {
+            clip[i] = face_transforms[face] * vec4(vertices[i].position, 1.0);
+        }
+        if (is_outside(clip[0], clip[1], clip[2])) {
+            continue;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            gl_Layer = face;
+            gl_Position = clip[i];
+            position = vertices[i].position;
+            texcoord = vertices[i].texcoord;
+            tbn = vertices[i].tbn;
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
@@ -1,24 +1,43 @@
 #version 330 core
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// world transforms of the scene nodes, 4 texels each
+uniform samplerBuffer model_data;
+
+layout (std140) uniform camera_data {
+    mat4 view;
+    mat4 projection;
+    vec3 camera_position;
+};
 
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec3 in_normal;
 layout (location = 2) in vec2 in_texcoord;
+// per instance, or a constant attribute for single objects
+layout (location = 3) in int in_model_index;
+
+out vertex_data {
+    vec3 position;
+    vec2 texcoord;
+    mat3 tbn;
+};
 
-out vec3 position;
-out vec2 texcoord;
-out vec3 cam_position;
-out mat3 tbn;
+mat4 get_model()
+{
+    int offset = 4 * in_model_index;
+    return mat4(
+        texelFetch(model_data, offset),
+        texelFetch(model_data, offset + 1),
+        texelFetch(model_data, offset + 2),
+        texelFetch(model_data, offset + 3)
+    );
+}
 
 void main()
 {
+    mat4 model = get_model();
     gl_Position = projection * view * model * vec4(in_position, 1.0);
     position = (model * vec4(in_position, 1.0)).xyz;
     texcoord = in_texcoord;
-    cam_position = (inverse(view) * vec4(0, 0, 0, 1)).xyz;
 
     vec3 normal = normalize((model * vec4(in_normal, 0.0)).xyz);
     vec3 t;
@@ -0,0 +1,25 @@
+#version 330 core
+
+// rgb: sum of weighted premultiplied colors, a: product of (1 - alpha)
+uniform sampler2D accumulation;
+// r: sum of weighted alphas
+uniform sampler2D weights;
+
+in vec2 texcoord;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+    vec4 accum = texture(accumulation, texcoord);
+    float revealage = accum.a;
+    if (revealage >= 1.0) {
+        discard;
+    }
+
+    float weight = texture(weights, texcoord).r;
+    vec3 average = accum.rgb / max(weight, 1e-5);
+
+    // blended with (1 - src_alpha, src_alpha)
+    out_color = vec4(average, revealage);
+}
@@ -1,9 +1,16 @@
 #version 330 core
 
+// a program variant fixes the mask, unused branches and fetches are compiled out
+#ifdef FEATURES
+const int textures_mask = FEATURES;
+#else
 uniform int textures_mask;
+#endif
 
 uniform sampler2D mask; // 1 << 4
 
+uniform bool rescaled_moments;
+
 layout (location = 0) out vec4 out_color;
 
 in vec2 texcoord;
@@ -11,12 +18,18 @@ in vec2 texcoord;
 void main() {
     bool use_mask = (textures_mask & (1 << 4)) != 0;
 
+    if (use_mask && texture(mask, texcoord).x < 0.5) {
+        discard;
+    }
+
     float z = gl_FragCoord.z;
     float dx = dFdx(z);
     float dy = dFdy(z);
     float z2 = z * z + 0.25 * (dx * dx + dy * dy);
 
-    float alpha = use_mask ? texture(mask, texcoord).x : 1.0;
+    if (rescaled_moments) {
+        z2 = 4.0 * (z2 - z) + 1.0;
+    }
 
-    out_color = vec4(z, z2, 0.0, alpha);
+    out_color = vec4(z, z2, 0.0, 1.0);
 }
\ No newline at end of file
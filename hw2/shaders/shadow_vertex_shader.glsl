@@ -1,14 +1,27 @@
 #version 330 core
 
-uniform mat4 model;
+// world transforms of the scene nodes, 4 texels each
+uniform samplerBuffer model_data;
 uniform mat4 transform;
 
 layout (location = 0) in vec3 in_position;
 layout (location = 2) in vec2 in_texcoord;
+// per instance, or a constant attribute for single objects
+layout (location = 3) in int in_model_index;
 
 out vec2 texcoord;
 
+mat4 get_model() {
+    int offset = 4 * in_model_index;
+    return mat4(
+        texelFetch(model_data, offset),
+        texelFetch(model_data, offset + 1),
+        texelFetch(model_data, offset + 2),
+        texelFetch(model_data, offset + 3)
+    );
+}
+
 void main() {
-    gl_Position = transform * model * vec4(in_position, 1.0);
+    gl_Position = transform * get_model() * vec4(in_position, 1.0);
     texcoord = in_texcoord;
 }
\ No newline at end of file
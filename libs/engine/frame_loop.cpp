@@ -0,0 +1,70 @@
+#include "frame_loop.hpp"
+
+#include <GL/glew.h>
+
+frame_loop::frame_loop(render_context &context) : _context(context), _last_frame_start(clock::now()) {}
+
+bool frame_loop::next_frame() {
+    input.begin_frame();
+    for (SDL_Event event; _running && !_context.is_headless() && SDL_PollEvent(&event);) {
+        switch (event.type) {
+            case SDL_QUIT:
+                _running = false;
+                break;
+            case SDL_WINDOWEVENT:
+                if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
+                    _context.resize(event.window.data1, event.window.data2);
+                    if (on_resize) {
+                        on_resize(event.window.data1, event.window.data2);
+                    }
+                }
+                break;
+            case SDL_KEYDOWN:
+            case SDL_KEYUP:
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+                input.handle(event);
+                break;
+        }
+        if (on_event) {
+            on_event(event);
+        }
+    }
+    if (!_running) {
+        return false;
+    }
+
+    auto now = clock::now();
+    _dt = _fixed_step > 0.f ? _fixed_step : std::chrono::duration<float>(now - _last_frame_start).count();
+    _last_frame_start = now;
+    _time += _dt;
+    _frame++;
+    return true;
+}
+
+void frame_loop::end_frame() {
+    _context.swap();
+    if (on_frame_time) {
+        on_frame_time(std::chrono::duration<double, std::milli>(clock::now() - _last_frame_start).count());
+    }
+}
+
+void frame_loop::stop() {
+    _running = false;
+}
+
+float frame_loop::get_dt() const {
+    return _dt;
+}
+
+float frame_loop::get_time() const {
+    return _time;
+}
+
+int frame_loop::get_frame() const {
+    return _frame;
+}
+
+void frame_loop::set_fixed_step(float dt) {
+    _fixed_step = dt;
+}
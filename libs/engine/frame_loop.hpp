@@ -0,0 +1,66 @@
+#pragma once
+
+#include "render_context.hpp"
+#include "input_state.hpp"
+
+#include <chrono>
+#include <functional>
+
+// Main loop of one render_context: polls events, measures frame times and presents frames.
+// Quit and resize are handled here, keys and mouse buttons go to input, then every event
+// is passed to on_event. Headless contexts have no events and run until stop.
+//
+//     frame_loop loop(context);
+//     while (loop.next_frame()) {
+//         update(loop.get_dt());
+//         draw();
+//         loop.end_frame();
+//     }
+class frame_loop {
+public:
+
+    explicit frame_loop(render_context& context);
+
+    // polls the events of a new frame, false once the window is closed or stop is called
+    bool next_frame();
+
+    // swaps and reports the frame time
+    void end_frame();
+
+    void stop();
+
+    // seconds since the previous frame, or the fixed step
+    float get_dt() const;
+
+    // sum of the steps so far
+    float get_time() const;
+
+    int get_frame() const;
+
+    // a step of 0 measures the wall-clock time, fixed steps make runs reproducible
+    void set_fixed_step(float dt);
+
+    input_state input;
+
+    std::function<void(const SDL_Event&)> on_event;
+
+    // after the context is resized
+    std::function<void(int width, int height)> on_resize;
+
+    // milliseconds from next_frame to the end of the swap
+    std::function<void(double)> on_frame_time;
+
+private:
+
+    using clock = std::chrono::high_resolution_clock;
+
+    render_context& _context;
+
+    bool _running = true;
+    float _fixed_step = 0.f;
+    float _dt = 0.f;
+    float _time = 0.f;
+    int _frame = -1;
+    clock::time_point _last_frame_start;
+
+};
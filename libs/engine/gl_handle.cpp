@@ -0,0 +1,29 @@
+#include "gl_handle.hpp"
+
+#include <iostream>
+#include <map>
+#include <string_view>
+
+namespace {
+
+// GL objects are only made on the thread of the context, no locking
+std::map<std::string_view, int> &live_objects() {
+    static std::map<std::string_view, int> counts;
+    return counts;
+}
+
+}
+
+void track_gl_object(const char *kind, int delta) {
+    live_objects()[kind] += delta;
+}
+
+void report_gl_leaks() {
+#ifndef NDEBUG
+    for (auto [kind, count] : live_objects()) {
+        if (count != 0) {
+            std::cerr << "GL leak: " << count << " " << kind << " handle(s) still alive" << std::endl;
+        }
+    }
+#endif
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <utility>
+
+// counts live handles per kind in debug builds, kind is the traits' name
+void track_gl_object(const char *kind, int delta);
+
+// prints the kinds with handles still alive to std::cerr, nothing in release builds;
+// render_context calls it before its GL context goes away. Names not owned by a gl_handle are not seen
+void report_gl_leaks();
+
+// Owns one GL object name and deletes it with the object. Move-only, converts to GLuint
+// so it goes straight into gl* calls. Traits provide name, create(args...) and destroy(id).
+template <typename Traits>
+class gl_handle {
+public:
+
+    gl_handle() = default;
+
+    // takes ownership of id
+    explicit gl_handle(GLuint id) : _id(id) {
+        track(_id, +1);
+    }
+
+    ~gl_handle() {
+        reset();
+    }
+
+    gl_handle(const gl_handle&) = delete;
+    gl_handle& operator=(const gl_handle&) = delete;
+
+    gl_handle(gl_handle&& other) noexcept : _id(std::exchange(other._id, 0)) {}
+
+    gl_handle& operator=(gl_handle&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    template <typename... Args>
+    static gl_handle create(Args... args) {
+        return gl_handle(Traits::create(args...));
+    }
+
+    GLuint get() const {
+        return _id;
+    }
+
+    operator GLuint() const {
+        return _id;
+    }
+
+    explicit operator bool() const {
+        return _id != 0;
+    }
+
+    // gives up ownership without deleting
+    GLuint release() {
+        track(_id, -1);
+        return std::exchange(_id, 0);
+    }
+
+    void reset(GLuint id = 0) {
+        if (_id != 0) {
+            track(_id, -1);
+            Traits::destroy(_id);
+        }
+        _id = id;
+        track(_id, +1);
+    }
+
+private:
+
+    static void track([[maybe_unused]] GLuint id, [[maybe_unused]] int delta) {
+#ifndef NDEBUG
+        if (id != 0) {
+            track_gl_object(Traits::name, delta);
+        }
+#endif
+    }
+
+    GLuint _id = 0;
+
+};
+
+struct gl_buffer_traits {
+    static constexpr const char *name = "buffer";
+
+    static GLuint create() {
+        GLuint id;
+        glGenBuffers(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteBuffers(1, &id);
+    }
+};
+
+struct gl_vertex_array_traits {
+    static constexpr const char *name = "vertex array";
+
+    static GLuint create() {
+        GLuint id;
+        glGenVertexArrays(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteVertexArrays(1, &id);
+    }
+};
+
+struct gl_texture_traits {
+    static constexpr const char *name = "texture";
+
+    static GLuint create() {
+        GLuint id;
+        glGenTextures(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteTextures(1, &id);
+    }
+};
+
+struct gl_framebuffer_traits {
+    static constexpr const char *name = "framebuffer";
+
+    static GLuint create() {
+        GLuint id;
+        glGenFramebuffers(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteFramebuffers(1, &id);
+    }
+};
+
+struct gl_renderbuffer_traits {
+    static constexpr const char *name = "renderbuffer";
+
+    static GLuint create() {
+        GLuint id;
+        glGenRenderbuffers(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteRenderbuffers(1, &id);
+    }
+};
+
+struct gl_query_traits {
+    static constexpr const char *name = "query";
+
+    static GLuint create() {
+        GLuint id;
+        glGenQueries(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteQueries(1, &id);
+    }
+};
+
+struct gl_shader_traits {
+    static constexpr const char *name = "shader";
+
+    static GLuint create(GLenum type) {
+        return glCreateShader(type);
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteShader(id);
+    }
+};
+
+struct gl_program_traits {
+    static constexpr const char *name = "program";
+
+    static GLuint create() {
+        return glCreateProgram();
+    }
+
+    static void destroy(GLuint id) {
+        glDeleteProgram(id);
+    }
+};
+
+using gl_buffer = gl_handle<gl_buffer_traits>;
+using gl_vertex_array = gl_handle<gl_vertex_array_traits>;
+using gl_texture = gl_handle<gl_texture_traits>;
+using gl_framebuffer = gl_handle<gl_framebuffer_traits>;
+using gl_renderbuffer = gl_handle<gl_renderbuffer_traits>;
+using gl_query = gl_handle<gl_query_traits>;
+using gl_shader = gl_handle<gl_shader_traits>;
+using gl_program = gl_handle<gl_program_traits>;
@@ -0,0 +1,87 @@
+#include "gl_utils.hpp"
+#include "gl_handle.hpp"
+#include "program_cache.hpp"
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <stdexcept>
+#include <string>
+
+void sdl2_fail(std::string_view message) {
+    throw std::runtime_error(std::string(message) + SDL_GetError());
+}
+
+void glew_fail(std::string_view message, GLenum error) {
+    throw std::runtime_error(std::string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
+}
+
+// the handles delete what failed to compile or link, hot reload keeps retrying edits
+GLuint create_shader(GLenum type, const char *source) {
+    gl_shader result = gl_shader::create(type);
+    glShaderSource(result, 1, &source, nullptr);
+    glCompileShader(result);
+    GLint status;
+    glGetShaderiv(result, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint info_log_length;
+        glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
+        std::string info_log(info_log_length, '\0');
+        glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
+        throw std::runtime_error("Shader compilation failed: " + info_log);
+    }
+    return result.release();
+}
+
+GLuint link_program(std::span<const GLuint> shaders) {
+    if (!is_program_cache_enabled()) {
+        return link_program_uncached(shaders);
+    }
+    std::uint64_t key = get_program_key(shaders);
+    if (GLuint result = load_program_binary(key)) {
+        return result;
+    }
+    GLuint result = link_program_uncached(shaders, true);
+    save_program_binary(key, result);
+    return result;
+}
+
+GLuint link_program_uncached(std::span<const GLuint> shaders, bool retrievable) {
+    gl_program result = gl_program::create();
+    if (retrievable) {
+        glProgramParameteri(result, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    for (GLuint shader : shaders) {
+        glAttachShader(result, shader);
+    }
+    glLinkProgram(result);
+
+    GLint status;
+    glGetProgramiv(result, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint info_log_length;
+        glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
+        std::string info_log(info_log_length, '\0');
+        glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
+        throw std::runtime_error("Program linkage failed: " + info_log);
+    }
+
+    return result.release();
+}
+
+GLuint create_program(GLuint vertex_shader, GLuint fragment_shader) {
+    GLuint shaders[] = {vertex_shader, fragment_shader};
+    return link_program(shaders);
+}
+
+GLuint create_program(GLuint vertex_shader, GLuint geometry_shader, GLuint fragment_shader) {
+    GLuint shaders[] = {vertex_shader, geometry_shader, fragment_shader};
+    return link_program(shaders);
+}
+
+GLuint create_compute_program(GLuint compute_shader) {
+    return link_program({&compute_shader, 1});
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <span>
+#include <string_view>
+
+// throw std::runtime_error with the message followed by the SDL or GLEW error
+[[noreturn]] void sdl2_fail(std::string_view message);
+
+[[noreturn]] void glew_fail(std::string_view message, GLenum error);
+
+GLuint create_shader(GLenum type, const char *source);
+
+// a binary from the program cache of the same shader sources skips the link, see program_cache.hpp
+GLuint link_program(std::span<const GLuint> shaders);
+
+// retrievable hints the driver that glGetProgramBinary follows
+GLuint link_program_uncached(std::span<const GLuint> shaders, bool retrievable = false);
+
+GLuint create_program(GLuint vertex_shader, GLuint fragment_shader);
+
+GLuint create_program(GLuint vertex_shader, GLuint geometry_shader, GLuint fragment_shader);
+
+GLuint create_compute_program(GLuint compute_shader);
@@ -0,0 +1,81 @@
+#include "headless_recorder.hpp"
+
+#include <GL/glew.h>
+
+#ifdef WITH_HEADLESS
+#include "headless.hpp"
+#else
+// never made without EGL, complete for the unique_ptr
+class frame_timer {};
+#endif
+
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+
+context_settings headless_options::apply(context_settings settings) const {
+    if (frames > 0) {
+        settings.headless = true;
+        if (width > 0 && height > 0) {
+            settings.width = width;
+            settings.height = height;
+        }
+    }
+    return settings;
+}
+
+headless_options parse_headless_options(int argc, char **argv) {
+    headless_options result;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--headless" && i + 1 < argc) {
+            result.frames = std::stoi(argv[++i]);
+        }
+        if (arg == "--output" && i + 1 < argc) {
+            result.output_directory = argv[++i];
+        }
+        if (arg == "--size" && i + 1 < argc && std::sscanf(argv[++i], "%dx%d", &result.width, &result.height) != 2) {
+            throw std::runtime_error("--size expects WIDTHxHEIGHT");
+        }
+    }
+    return result;
+}
+
+headless_recorder::headless_recorder(const render_context &context, frame_loop &loop, const headless_options &options)
+    : _context(context), _loop(loop), _options(options) {
+    if (!_context.is_headless()) {
+        return;
+    }
+#ifdef WITH_HEADLESS
+    std::filesystem::create_directories(_options.output_directory);
+    // fixed steps keep the frames reproducible
+    _loop.set_fixed_step(1.f / 60.f);
+    _timer = std::make_unique<frame_timer>();
+    _timer->start();
+#endif
+}
+
+headless_recorder::~headless_recorder() = default;
+
+void headless_recorder::capture() {
+    if (!_timer) {
+        return;
+    }
+#ifdef WITH_HEADLESS
+    _timer->stop();
+    // the frame may end with an offscreen framebuffer bound for reading
+    GLint read_framebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%04d.png", _loop.get_frame());
+    write_png((_options.output_directory / name).string(), _context.get_width(), _context.get_height());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+
+    if (_loop.get_frame() + 1 >= _options.frames) {
+        _timer->write_csv((_options.output_directory / "timings.csv").string());
+        _loop.stop();
+    }
+    _timer->start();
+#endif
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "frame_loop.hpp"
+#include "render_context.hpp"
+
+#include <filesystem>
+#include <memory>
+
+class frame_timer;
+
+// --headless N renders N frames without a window at a fixed step and writes them as
+// frame_NNNN.png with their timings.csv to --output, --size WxH sets the framebuffer size
+struct headless_options {
+    int frames = 0;
+    std::filesystem::path output_directory = ".";
+    // 0 keeps the size of the context settings
+    int width = 0;
+    int height = 0;
+
+    // settings with headless and the size set when N > 0, unchanged otherwise
+    context_settings apply(context_settings settings) const;
+};
+
+// other arguments are skipped, throws std::runtime_error on a malformed --size
+headless_options parse_headless_options(int argc, char **argv);
+
+// Writes the frames of a headless loop and stops it after the last one, does nothing with a window.
+//
+//     headless_recorder recorder(context, loop, headless);
+//     while (loop.next_frame()) {
+//         draw();
+//         recorder.capture();
+//         loop.end_frame();
+//     }
+class headless_recorder {
+public:
+
+    headless_recorder(const render_context& context, frame_loop& loop, const headless_options& options);
+
+    ~headless_recorder();
+
+    headless_recorder(const headless_recorder&) = delete;
+    headless_recorder& operator=(const headless_recorder&) = delete;
+
+    // reads the default framebuffer, each time runs from the previous capture
+    void capture();
+
+private:
+
+    const render_context& _context;
+    frame_loop& _loop;
+    headless_options _options;
+    std::unique_ptr<frame_timer> _timer;
+
+};
@@ -0,0 +1,188 @@
+#include "program_cache.hpp"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "gl_handle.hpp"
+#include "gl_utils.hpp"
+
+namespace {
+
+std::optional<std::filesystem::path> cache_directory;
+
+const char cache_magic[4] = {'P', 'R', 'G', 'B'};
+
+std::filesystem::path get_cache_directory() {
+    if (!cache_directory.has_value()) {
+        std::error_code error;
+        auto temp = std::filesystem::temp_directory_path(error);
+        cache_directory = error ? std::filesystem::path() : temp / "graphics-course-programs";
+    }
+    return cache_directory.value();
+}
+
+std::filesystem::path get_path(std::uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+    return get_cache_directory() / name;
+}
+
+void hash(std::uint64_t& result, std::string_view data) {
+    for (char c : data) {
+        result = (result ^ (std::uint8_t) c) * 1099511628211ull;
+    }
+    // separates consecutive strings
+    result = (result ^ 0xff) * 1099511628211ull;
+}
+
+}
+
+void set_program_cache_directory(std::filesystem::path directory) {
+    cache_directory = std::move(directory);
+}
+
+bool is_program_cache_enabled() {
+    if (!GLEW_ARB_get_program_binary || get_cache_directory().empty()) {
+        return false;
+    }
+    GLint format_number = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_number);
+    return format_number > 0;
+}
+
+std::uint64_t get_program_key(std::span<const shader_source> shaders) {
+    std::uint64_t result = 14695981039346656037ull;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        auto value = reinterpret_cast<const char *>(glGetString(name));
+        hash(result, value != nullptr ? value : "");
+    }
+    for (auto [type, source] : shaders) {
+        hash(result, std::to_string(type));
+        hash(result, source);
+    }
+    return result;
+}
+
+std::uint64_t get_program_key(std::span<const GLuint> shaders) {
+    // reserved up front, the keyed pointers must outlive every push_back
+    std::vector<std::string> sources;
+    sources.reserve(shaders.size());
+    std::vector<shader_source> keyed;
+    for (GLuint shader : shaders) {
+        GLint type = 0;
+        GLint length = 0;
+        glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+        glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &length);
+        // the length counts the terminating null
+        std::string& source = sources.emplace_back(std::max(length, 1), '\0');
+        glGetShaderSource(shader, length, nullptr, source.data());
+        source.resize(std::max(length - 1, 0));
+        keyed.emplace_back((GLenum) type, source.c_str());
+    }
+    return get_program_key(keyed);
+}
+
+GLuint load_program_binary(std::uint64_t key) {
+    if (!is_program_cache_enabled()) {
+        return 0;
+    }
+
+    std::ifstream in(get_path(key), std::ios::binary);
+    char magic[4] = {};
+    std::uint64_t stored_key = 0;
+    GLenum format = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&stored_key), sizeof(stored_key));
+    in.read(reinterpret_cast<char *>(&format), sizeof(format));
+    if (!in || !std::equal(magic, magic + 4, cache_magic) || stored_key != key) {
+        return 0;
+    }
+    std::vector<char> binary{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    GLuint result = glCreateProgram();
+    glProgramBinary(result, format, binary.data(), (GLsizei) binary.size());
+    // drivers reject binaries after an update even with the same version string
+    GLint status;
+    glGetProgramiv(result, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(result);
+        return 0;
+    }
+    return result;
+}
+
+void save_program_binary(std::uint64_t key, GLuint program) {
+    if (!is_program_cache_enabled()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(get_cache_directory(), error);
+    // written aside and renamed so a concurrent start never reads a partial file,
+    // the pid keeps instances starting together from writing the same temp file
+    auto path = get_path(key);
+    auto temp_path = path;
+    temp_path += "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary);
+        out.write(cache_magic, sizeof(cache_magic));
+        out.write(reinterpret_cast<const char *>(&key), sizeof(key));
+        out.write(reinterpret_cast<const char *>(&format), sizeof(format));
+        out.write(binary.data(), length);
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+    }
+}
+
+GLuint create_cached_program(std::span<const shader_source> shaders) {
+    std::uint64_t key = get_program_key(shaders);
+    if (GLuint result = load_program_binary(key)) {
+        return result;
+    }
+
+    // owned until linked, a failing shader or link must not leak the ones compiled before
+    std::vector<gl_shader> shader_objects;
+    std::vector<GLuint> shader_names;
+    for (auto [type, source] : shaders) {
+        shader_objects.emplace_back(create_shader(type, source));
+        shader_names.push_back(shader_objects.back());
+    }
+    // the retrievable hint needs glProgramParameteri, missing without program binaries
+    GLuint result = link_program_uncached(shader_names, is_program_cache_enabled());
+    for (GLuint shader : shader_names) {
+        glDetachShader(result, shader);
+    }
+
+    save_program_binary(key, result);
+    return result;
+}
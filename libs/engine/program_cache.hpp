@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+#include <GL/glew.h>
+
+// Linked program binaries kept on disk, keyed by a hash of the shader sources
+// and the driver vendor, renderer and version. A missing, stale or rejected
+// binary falls back to compiling the sources, which then replace it.
+// link_program and create_program of gl_utils go through it as well.
+
+using shader_source = std::pair<GLenum, const char *>;
+
+// empty disables the cache, by default a directory in the system temp directory
+void set_program_cache_directory(std::filesystem::path directory);
+
+// false without a directory or a driver storing program binaries
+bool is_program_cache_enabled();
+
+std::uint64_t get_program_key(std::span<const shader_source> shaders);
+
+// the same key as the sources the compiled shaders were created from
+std::uint64_t get_program_key(std::span<const GLuint> shaders);
+
+// 0 if there is no usable binary for key
+GLuint load_program_binary(std::uint64_t key);
+
+void save_program_binary(std::uint64_t key, GLuint program);
+
+// compiles and links the shaders unless their program is cached
+GLuint create_cached_program(std::span<const shader_source> shaders);
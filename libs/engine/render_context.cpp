@@ -0,0 +1,108 @@
+#include "render_context.hpp"
+#include "gl_utils.hpp"
+#include "gl_handle.hpp"
+
+#ifdef WITH_HEADLESS
+#include "headless.hpp"
+#else
+// never made without EGL, complete for the unique_ptr
+class headless_context {};
+#endif
+
+#include <stdexcept>
+
+render_context::render_context(const context_settings &settings)
+    : _width(settings.width), _height(settings.height) {
+    if (settings.headless) {
+#ifdef WITH_HEADLESS
+        // no multisampling, the frames are compared between hosts
+        _offscreen = std::make_unique<headless_context>(settings.width, settings.height);
+#else
+        throw std::runtime_error("Headless mode needs EGL, which was not found when building");
+#endif
+    } else {
+        if (SDL_Init(SDL_INIT_VIDEO) != 0)
+            sdl2_fail("SDL_Init: ");
+
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+        if (settings.samples > 0) {
+            SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
+            SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, settings.samples);
+        }
+        SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+        SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+        SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+        SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, settings.depth_bits);
+        SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, settings.stencil_bits);
+
+        _window = SDL_CreateWindow(settings.title.c_str(),
+                                   SDL_WINDOWPOS_CENTERED,
+                                   SDL_WINDOWPOS_CENTERED,
+                                   settings.width, settings.height,
+                                   SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
+
+        if (!_window)
+            sdl2_fail("SDL_CreateWindow: ");
+
+        SDL_GetWindowSize(_window, &_width, &_height);
+
+        _gl_context = SDL_GL_CreateContext(_window);
+        if (!_gl_context)
+            sdl2_fail("SDL_GL_CreateContext: ");
+
+        if (settings.swap_interval != 1) {
+            SDL_GL_SetSwapInterval(settings.swap_interval);
+        }
+    }
+
+    if (auto result = glewInit(); result != GLEW_NO_ERROR) {
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+        // GLX builds of GLEW load the core functions before looking for an X display
+        if (!settings.headless || result != GLEW_ERROR_NO_GLX_DISPLAY)
+#endif
+        glew_fail("glewInit: ", result);
+    }
+
+    if (!GLEW_VERSION_3_3)
+        throw std::runtime_error("OpenGL 3.3 is not supported");
+}
+
+render_context::~render_context() {
+    // everything made after the context is gone by now
+    report_gl_leaks();
+    if (_window) {
+        SDL_GL_DeleteContext(_gl_context);
+        SDL_DestroyWindow(_window);
+    }
+}
+
+SDL_Window *render_context::get_window() const {
+    return _window;
+}
+
+bool render_context::is_headless() const {
+    return _window == nullptr;
+}
+
+int render_context::get_width() const {
+    return _width;
+}
+
+int render_context::get_height() const {
+    return _height;
+}
+
+void render_context::resize(int width, int height) {
+    _width = width;
+    _height = height;
+    glViewport(0, 0, width, height);
+}
+
+void render_context::swap() {
+    if (_window) {
+        SDL_GL_SwapWindow(_window);
+    }
+}
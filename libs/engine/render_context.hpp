@@ -0,0 +1,63 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <memory>
+#include <string>
+
+class headless_context;
+
+struct context_settings {
+    std::string title;
+    // initial size of the window, which starts maximized; the framebuffer size when headless
+    int width = 800;
+    int height = 600;
+    // multisampled default framebuffer, 0 for none
+    int samples = 0;
+    int depth_bits = 24;
+    int stencil_bits = 0;
+    // 0 swaps as fast as possible, frame times then measure the frames
+    int swap_interval = 1;
+    // offscreen EGL context without a window or events, needs WITH_HEADLESS
+    bool headless = false;
+};
+
+// SDL window with an OpenGL 3.3 core context, or a headless one, and GLEW loaded for it
+class render_context {
+public:
+
+    explicit render_context(const context_settings& settings);
+
+    ~render_context();
+
+    render_context(const render_context&) = delete;
+    render_context& operator=(const render_context&) = delete;
+
+    // nullptr when headless
+    SDL_Window *get_window() const;
+
+    bool is_headless() const;
+
+    int get_width() const;
+    int get_height() const;
+
+    // new size of the default framebuffer, also sets the viewport
+    void resize(int width, int height);
+
+    // presents the frame, nothing to present when headless
+    void swap();
+
+private:
+
+    SDL_Window *_window = nullptr;
+    SDL_GLContext _gl_context = nullptr;
+    std::unique_ptr<headless_context> _offscreen;
+
+    int _width = 0;
+    int _height = 0;
+
+};
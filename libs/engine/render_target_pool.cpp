@@ -0,0 +1,86 @@
+#include "render_target_pool.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+render_target_pool::lease::lease(entry *target) : _target(target) {
+    _target->in_use = true;
+}
+
+render_target_pool::lease::~lease() {
+    if (_target) {
+        _target->in_use = false;
+    }
+}
+
+render_target_pool::lease::lease(lease &&other) noexcept : _target(std::exchange(other._target, nullptr)) {}
+
+render_target_pool::lease &render_target_pool::lease::operator=(lease &&other) noexcept {
+    if (this != &other) {
+        if (_target) {
+            _target->in_use = false;
+        }
+        _target = std::exchange(other._target, nullptr);
+    }
+    return *this;
+}
+
+GLuint render_target_pool::lease::texture() const {
+    return _target ? _target->texture.get() : 0;
+}
+
+GLuint render_target_pool::lease::fbo() const {
+    return _target ? _target->fbo.get() : 0;
+}
+
+render_target_pool::lease::operator bool() const {
+    return _target != nullptr;
+}
+
+render_target_pool::lease render_target_pool::acquire(GLenum internal_format, int width, int height) {
+    for (auto &target : _targets) {
+        if (!target->in_use && target->format == internal_format
+            && target->width == width && target->height == height) {
+            target->last_used = _frame;
+            return lease(target.get());
+        }
+    }
+
+    auto target = std::make_unique<entry>();
+    target->format = internal_format;
+    target->width = width;
+    target->height = height;
+    target->last_used = _frame;
+
+    // the caller's texture unit gets the new texture bound, as when it made its own
+    target->texture = gl_texture::create();
+    glBindTexture(GL_TEXTURE_2D, target->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    GLint previous_fbo = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_fbo);
+    target->fbo = gl_framebuffer::create();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target->fbo);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target->texture, 0);
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete framebuffer!");
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_fbo);
+
+    _targets.push_back(std::move(target));
+    return lease(_targets.back().get());
+}
+
+void render_target_pool::end_frame(int max_unused_frames) {
+    _frame++;
+    std::erase_if(_targets, [&](const std::unique_ptr<entry> &target) {
+        return !target->in_use && _frame - target->last_used > max_unused_frames;
+    });
+}
+
+int render_target_pool::size() const {
+    return (int) _targets.size();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <memory>
+#include <vector>
+
+#include "gl_handle.hpp"
+
+// Transient color targets shared between passes: a 2D texture of some format and size and a
+// framebuffer with it as color attachment 0. A lease hands the target back when dropped and the
+// next pass asking for the same format and size gets it again, so nothing is reallocated between
+// passes or frames; targets nobody asked for in a while, e.g. of an old size, are deleted.
+class render_target_pool {
+
+    struct entry {
+        gl_texture texture;
+        gl_framebuffer fbo;
+        GLenum format = 0;
+        int width = 0;
+        int height = 0;
+        bool in_use = false;
+        // frame of the pool the target was last handed out in
+        int last_used = 0;
+    };
+
+public:
+
+    class lease {
+    public:
+
+        lease() = default;
+
+        ~lease();
+
+        lease(const lease&) = delete;
+        lease& operator=(const lease&) = delete;
+
+        lease(lease&& other) noexcept;
+        lease& operator=(lease&& other) noexcept;
+
+        GLuint texture() const;
+
+        GLuint fbo() const;
+
+        explicit operator bool() const;
+
+    private:
+
+        friend class render_target_pool;
+
+        explicit lease(entry *target);
+
+        entry *_target = nullptr;
+
+    };
+
+    render_target_pool() = default;
+
+    render_target_pool(const render_target_pool&) = delete;
+    render_target_pool& operator=(const render_target_pool&) = delete;
+
+    // normalized or float color formats, the texture filters linearly and clamps to edge;
+    // its contents are undefined, the pool must outlive the lease
+    lease acquire(GLenum internal_format, int width, int height);
+
+    // deletes free targets not acquired in the last max_unused_frames frames, called once a frame
+    void end_frame(int max_unused_frames = 60);
+
+    // all targets, leased or not
+    int size() const;
+
+private:
+
+    // entries don't move, leases point to them
+    std::vector<std::unique_ptr<entry>> _targets;
+    int _frame = 0;
+
+};
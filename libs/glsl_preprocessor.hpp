@@ -0,0 +1,120 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Resolves #include "file" directives of a GLSL shader relative to the including file.
+// Used by libs/glslpreprocess at build time and by hw2's hot reload, which must produce
+// the same text from the same files.
+//
+// Every file is included once. The result starts with #version, the index and path of each
+// file relative to the shader in comments and the given define lines; #line directives keep
+// compiler messages pointing at the original files. Throws std::runtime_error when a file
+// can't be read or has a malformed directive.
+class glsl_preprocessor {
+public:
+
+    // defines are whole lines such as "#define NAME VALUE"
+    std::string process(const std::filesystem::path& path, const std::vector<std::string>& defines = {});
+
+    // files read by the last process call, the shader first
+    const std::vector<std::filesystem::path>& get_files() const;
+
+private:
+
+    void include(const std::filesystem::path& path, int depth);
+
+    std::vector<std::filesystem::path> _files;
+    std::ostringstream _body;
+    std::string _version;
+
+};
+
+inline std::string glsl_preprocessor::process(
+    const std::filesystem::path& path,
+    const std::vector<std::string>& defines
+) {
+    _files.clear();
+    _body.str("");
+    _version.clear();
+
+    std::filesystem::path shader = path.lexically_normal();
+    include(shader, 0);
+    if (_version.empty()) {
+        throw std::runtime_error(shader.string() + ": no #version directive");
+    }
+
+    std::ostringstream result;
+    result << _version << "\n";
+    for (std::size_t i = 0; i < _files.size(); i++) {
+        result << "// " << i << ": " << _files[i].lexically_relative(shader.parent_path()).generic_string() << "\n";
+    }
+    for (const std::string& define : defines) {
+        result << define << "\n";
+    }
+    result << _body.str();
+    return result.str();
+}
+
+inline const std::vector<std::filesystem::path>& glsl_preprocessor::get_files() const {
+    return _files;
+}
+
+inline void glsl_preprocessor::include(const std::filesystem::path& path, int depth) {
+    if (depth > 32) {
+        throw std::runtime_error("Include depth exceeded in " + path.string());
+    }
+    for (const auto& file : _files) {
+        if (file == path) {
+            return;
+        }
+    }
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Can't open file " + path.string());
+    }
+    int index = (int) _files.size();
+    _files.push_back(path);
+    if (index > 0) {
+        _body << "#line 1 " << index << "\n";
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::size_t start = line.find_first_not_of(" \t");
+        std::string_view directive = start == std::string::npos ? std::string_view() : std::string_view(line).substr(start);
+        std::string location = path.string() + ":" + std::to_string(line_number);
+
+        if (directive.starts_with("#version")) {
+            if (index > 0) {
+                throw std::runtime_error(location + ": #version in an included file");
+            }
+            _version = line;
+            _body << "#line " << line_number + 1 << " 0\n";
+            continue;
+        }
+        if (!directive.starts_with("#include")) {
+            _body << line << "\n";
+            continue;
+        }
+
+        std::size_t open = line.find('"');
+        std::size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            throw std::runtime_error(location + ": expected #include \"file\"");
+        }
+        try {
+            include((path.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal(), depth + 1);
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error(std::string(e.what()) + "\n  included from " + location);
+        }
+        _body << "#line " << line_number + 1 << " " << index << "\n";
+    }
+}
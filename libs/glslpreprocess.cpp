@@ -0,0 +1,115 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "glsl_preprocessor.hpp"
+
+// Writes a GLSL shader with its #include directives resolved by glsl_preprocessor,
+// defines given as NAME or NAME=VALUE are inserted after the list of files.
+//
+// The output is only rewritten when it changes, the depfile lists every file that was read.
+// With --stamp the stamp file is touched on every run and is the target of the depfile,
+// for build tools that can't tell an unchanged output from an outdated one.
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string escapeDependency(const std::string &path) {
+    std::string result;
+    for (char c : path) {
+        if (c == ' ' || c == '#') {
+            result += '\\';
+        } else if (c == '$') {
+            result += '$';
+        }
+        result += c;
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::string stampFilename;
+    if (argc > 2 && std::string_view(argv[1]) == "--stamp") {
+        stampFilename = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " [--stamp <stampFile>] <sourceFile> <outputFile> <depFile> [NAME[=VALUE]...]" << std::endl;
+        return 1;
+    }
+
+    fs::path sourceFilename = fs::absolute(argv[1]).lexically_normal();
+    std::string outputFilename(argv[2]);
+    std::string depFilename(argv[3]);
+
+    std::vector<std::string> defines;
+    for (int i = 4; i < argc; ++i) {
+        std::string define(argv[i]);
+        std::size_t equals = define.find('=');
+        if (equals == std::string::npos) {
+            defines.push_back("#define " + define);
+        } else {
+            defines.push_back("#define " + define.substr(0, equals) + " " + define.substr(equals + 1));
+        }
+    }
+
+    // paths in the file list are relative to the shader, hw2 reloads sources from disk by it
+    glsl_preprocessor preprocessor;
+    std::string output;
+    try {
+        output = preprocessor.process(sourceFilename, defines);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // unchanged output keeps the generated header and its includers up to date
+    for (const fs::path &path : {fs::path(outputFilename), fs::path(depFilename), fs::path(stampFilename)}) {
+        if (path.has_parent_path()) {
+            fs::create_directories(path.parent_path());
+        }
+    }
+    std::ifstream existing(outputFilename, std::ios::binary);
+    std::string previous((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+    if (!existing.is_open() || previous != output) {
+        std::ofstream fout(outputFilename, std::ios::binary);
+        fout << output;
+        if (!fout) {
+            std::cerr << "Can't write file " << outputFilename << "!" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!stampFilename.empty()) {
+        std::ofstream stamp(stampFilename);
+        std::error_code error;
+        // opening an existing empty file doesn't update its time everywhere
+        fs::last_write_time(stampFilename, fs::file_time_type::clock::now(), error);
+        if (!stamp || error) {
+            std::cerr << "Can't write file " << stampFilename << "!" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream dep(depFilename);
+    dep << escapeDependency(stampFilename.empty() ? outputFilename : stampFilename) << ":";
+    for (const fs::path &file : preprocessor.get_files()) {
+        dep << " \\\n  " << escapeDependency(file.generic_string());
+    }
+    dep << "\n";
+    if (!dep) {
+        std::cerr << "Can't write file " << depFilename << "!" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include "headless.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+[[noreturn]] void egl_fail(const std::string& message) {
+    std::ostringstream error;
+    error << message << ": EGL error 0x" << std::hex << eglGetError();
+    throw std::runtime_error(error.str());
+}
+
+EGLDisplay get_display() {
+    // the client extension string is null without EGL_EXT_client_extensions
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions != nullptr && std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display != nullptr) {
+            EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+std::uint32_t crc32(const std::uint8_t *data, std::size_t size, std::uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> result{};
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            result[i] = c;
+        }
+        return result;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void put_u32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((std::uint8_t) (value >> shift));
+    }
+}
+
+void write_chunk(std::ofstream& out, const char *type, const std::vector<std::uint8_t>& data) {
+    std::vector<std::uint8_t> chunk;
+    put_u32(chunk, (std::uint32_t) data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put_u32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    out.write(reinterpret_cast<const char *>(chunk.data()), (std::streamsize) chunk.size());
+}
+
+}
+
+headless_context::headless_context(int width, int height) : _width(width), _height(height) {
+    EGLDisplay display = get_display();
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        egl_fail("eglInitialize");
+    }
+    _display = display;
+
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_STENCIL_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_number = 0;
+    if (!eglChooseConfig(display, config_attributes, &config, 1, &config_number) || config_number == 0) {
+        egl_fail("eglChooseConfig");
+    }
+
+    const EGLint surface_attributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    _surface = eglCreatePbufferSurface(display, config, surface_attributes);
+    if (_surface == EGL_NO_SURFACE) {
+        egl_fail("eglCreatePbufferSurface");
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        egl_fail("eglBindAPI");
+    }
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    _context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (_context == EGL_NO_CONTEXT) {
+        egl_fail("eglCreateContext");
+    }
+    if (!eglMakeCurrent(display, _surface, _surface, _context)) {
+        egl_fail("eglMakeCurrent");
+    }
+}
+
+headless_context::~headless_context() {
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (_context != nullptr) {
+        eglDestroyContext(_display, _context);
+    }
+    if (_surface != nullptr) {
+        eglDestroySurface(_display, _surface);
+    }
+    eglTerminate(_display);
+}
+
+int headless_context::get_width() const {
+    return _width;
+}
+
+int headless_context::get_height() const {
+    return _height;
+}
+
+void write_png(const std::string &path, int width, int height) {
+    std::size_t row_size = 3 * (std::size_t) width;
+    std::vector<std::uint8_t> pixels(row_size * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    // rows flipped to top first, each with filter type 0
+    std::vector<std::uint8_t> raw;
+    raw.reserve((row_size + 1) * height);
+    for (int y = height - 1; y >= 0; y--) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels.begin() + y * row_size, pixels.begin() + (y + 1) * row_size);
+    }
+
+    // zlib stream of stored deflate blocks, frames are written fast rather than small
+    std::vector<std::uint8_t> compressed = {0x78, 0x01};
+    std::uint32_t a = 1, b = 0;
+    for (std::size_t offset = 0; offset < raw.size();) {
+        std::size_t size = std::min<std::size_t>(raw.size() - offset, 65535);
+        bool last = offset + size == raw.size();
+        compressed.push_back(last ? 1 : 0);
+        compressed.push_back((std::uint8_t) size);
+        compressed.push_back((std::uint8_t) (size >> 8));
+        compressed.push_back((std::uint8_t) ~size);
+        compressed.push_back((std::uint8_t) (~size >> 8));
+        for (std::size_t i = offset; i < offset + size; i++) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        compressed.insert(compressed.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    }
+    put_u32(compressed, (b << 16) | a);
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Can't write " + path);
+    }
+    const std::uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    out.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    std::vector<std::uint8_t> header;
+    put_u32(header, (std::uint32_t) width);
+    put_u32(header, (std::uint32_t) height);
+    // 8 bit RGB, deflate, adaptive filtering, no interlace
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    write_chunk(out, "IHDR", header);
+    write_chunk(out, "IDAT", compressed);
+    write_chunk(out, "IEND", {});
+}
+
+void frame_timer::start() {
+    _start = std::chrono::steady_clock::now();
+}
+
+double frame_timer::stop() {
+    glFinish();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+    _times.push_back(ms);
+    return ms;
+}
+
+const std::vector<double> &frame_timer::get_times() const {
+    return _times;
+}
+
+void frame_timer::write_csv(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Can't write " + path);
+    }
+    out << "frame,ms\n";
+    for (std::size_t i = 0; i < _times.size(); i++) {
+        out << i << "," << _times[i] << "\n";
+    }
+}
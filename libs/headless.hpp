@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// OpenGL 3.3 core context without a window, made with EGL on the Mesa surfaceless platform
+// when available, so it runs on CI hosts without a display or GPU (llvmpipe).
+// A pbuffer is the default framebuffer, code drawing to framebuffer 0 works unchanged.
+class headless_context {
+public:
+
+    headless_context(int width, int height);
+
+    ~headless_context();
+
+    headless_context(const headless_context&) = delete;
+    headless_context& operator=(const headless_context&) = delete;
+
+    int get_width() const;
+    int get_height() const;
+
+private:
+
+    void *_display = nullptr;
+    void *_surface = nullptr;
+    void *_context = nullptr;
+
+    int _width = 0;
+    int _height = 0;
+
+};
+
+// writes the color of the bound read framebuffer as an 8 bit RGB png, top row first
+void write_png(const std::string& path, int width, int height);
+
+// wall-clock time of each frame, glFinish in stop includes the GPU work
+class frame_timer {
+public:
+
+    void start();
+
+    // milliseconds since start
+    double stop();
+
+    const std::vector<double>& get_times() const;
+
+    // frame number and milliseconds per line
+    void write_csv(const std::string& path) const;
+
+private:
+
+    std::chrono::steady_clock::time_point _start;
+    std::vector<double> _times;
+
+};
@@ -1,74 +1,237 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <iomanip>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <vector>
+
+// Embeds a file as a NUL-terminated char array.
+//
+// A header gets a static array with its _length, a .cpp source gets an
+// external unsigned char array for a declaration elsewhere. Sources can hold
+// the data as
+//   array  - an initializer formatted through a lookup table,
+//   embed  - a C23 #embed directive, the compiler reads the file itself,
+//   incbin - an assembler .incbin, GNU toolchains on ELF targets,
+// the last two keep generated files tiny and compile in a fraction of the time.
+// Headers are always arrays: they are included by several sources and a
+// signed char can't be initialized from #embed bytes >= 128.
+//
+// With --stamp the output is only replaced when its text changes, so its includers stay
+// up to date, and the stamp file is touched on every run instead, for build tools that
+// compare times only and would otherwise rerun the step until the output changes.
+// Its depfile makes the stamp depend on the output, a deleted output reruns the step.
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// "-0x12, " for every byte value, bytes >= 128 are negative for a signed char
+struct Table {
+    char text[256][8];
+    unsigned char length[256];
+
+    Table(bool isSigned) {
+        const char *digits = "0123456789abcdef";
+        for (int value = 0; value < 256; ++value) {
+            int magnitude = value;
+            int n = 0;
+            if (isSigned && value >= 128) {
+                text[value][n++] = '-';
+                magnitude = 256 - value;
+            }
+            text[value][n++] = '0';
+            text[value][n++] = 'x';
+            text[value][n++] = digits[magnitude >> 4];
+            text[value][n++] = digits[magnitude & 15];
+            text[value][n++] = ',';
+            text[value][n++] = ' ';
+            length[value] = (unsigned char) n;
+        }
+    }
+};
+
+std::string escape(const std::string &path) {
+    std::string result;
+    for (char c : path) {
+        if (c == '\\' || c == '"') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+std::string escapeDependency(const std::string &path) {
+    std::string result;
+    for (char c : path) {
+        if (c == ' ' || c == '#') {
+            result += '\\';
+        } else if (c == '$') {
+            result += '$';
+        }
+        result += c;
+    }
+    return result;
+}
+
+bool writeArray(std::FILE *fin, std::FILE *fout, bool isSigned) {
+    static const Table signedTable(true);
+    static const Table unsignedTable(false);
+    const Table &table = isSigned ? signedTable : unsignedTable;
+
+    const int bytesInLine = 120 / 6;
+    std::vector<unsigned char> input(1 << 20);
+    std::vector<char> output;
+    output.reserve(input.size() * 8 + input.size() / bytesInLine + 1);
+
+    int column = 0;
+    std::size_t n;
+    while ((n = std::fread(input.data(), 1, input.size(), fin)) > 0) {
+        output.clear();
+        for (std::size_t i = 0; i < n; ++i) {
+            unsigned char value = input[i];
+            output.insert(output.end(), table.text[value], table.text[value] + table.length[value]);
+            if (++column == bytesInLine) {
+                output.push_back('\n');
+                column = 0;
+            }
+        }
+        if (std::fwrite(output.data(), 1, output.size(), fout) != output.size()) {
+            return false;
+        }
+    }
+    std::fputs("0x00, \n", fout);
+    return !std::ferror(fin);
+}
+
+bool isSameFile(const std::string &first, const std::string &second) {
+    std::ifstream a(first, std::ios::binary);
+    std::ifstream b(second, std::ios::binary);
+    if (!a.is_open() || !b.is_open()) {
+        return false;
+    }
+    return std::equal(std::istreambuf_iterator<char>(a), std::istreambuf_iterator<char>(),
+                      std::istreambuf_iterator<char>(b), std::istreambuf_iterator<char>());
+}
+
+}
 
 int main(int argc, char **argv)
 {
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <sourceFile> <headerFile> <arrayName>" << std::endl;
+    std::string stampFilename;
+    std::string depFilename;
+    if (argc > 3 && std::string_view(argv[1]) == "--stamp") {
+        stampFilename = argv[2];
+        depFilename = argv[3];
+        argv += 3;
+        argc -= 3;
+    }
+    if (argc != 4 && argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " [--stamp <stampFile> <depFile>] <sourceFile> <headerFile|sourceFile.cpp> <arrayName> [array|embed|incbin]" << std::endl;
         return 1;
     }
 
     std::string sourceFilename(argv[1]);
-    std::string headerFilename(argv[2]);
+    std::string outputFilename(argv[2]);
     std::string arrayName(argv[3]);
+    std::string mode(argc == 5 ? argv[4] : "array");
 
-    std::ifstream fin(sourceFilename, std::ios::binary);
-    std::ofstream fout(headerFilename);
+    bool isSource = outputFilename.ends_with(".cpp");
+    if (mode != "array" && mode != "embed" && mode != "incbin") {
+        std::cerr << "Unknown mode " << mode << "!" << std::endl;
+        return 1;
+    }
+    if (!isSource) {
+        mode = "array";
+    }
 
+    std::FILE *fin = std::fopen(sourceFilename.c_str(), "rb");
     if (!fin) {
         std::cerr << "Can't open file " << sourceFilename << "!" << std::endl;
         return 1;
     }
+    // written aside, replaces the output when complete
+    std::string tempFilename = outputFilename + ".tmp";
+    std::FILE *fout = std::fopen(tempFilename.c_str(), "wb");
+    if (!fout) {
+        std::cerr << "Can't open file " << tempFilename << "!" << std::endl;
+        std::fclose(fin);
+        return 1;
+    }
 
-    fout << "#include <cstddef>" << std::endl;
-    fout << std::endl;
-    fout << "static const char " << arrayName << "[] = {" << std::endl;
-
-    char buffer[2391];
-    const int maxBytesInLine = 120 / 6;
-    int bytesInLine = 0;
+    // the compiler and the assembler resolve relative paths from elsewhere
+    std::string absolutePath = escape(fs::absolute(sourceFilename).generic_string());
+    std::string declaration = isSource
+        ? "unsigned char " + arrayName + "[]"
+        : "static const char " + arrayName + "[]";
 
-    std::streamsize n;
-    do {
-        fin.read(buffer, sizeof(buffer) / sizeof(char));
-        n = fin.gcount();
-        for (std::streamsize i = 0; i < n; ++i) {
-            unsigned int value = (unsigned int) buffer[i];
-            if (value > 0xff) {
-                value -= 0xffffff00;
-            }
-            if (value >= 128) {
-                fout << "-";
-                value = 256 - value;
-            }
-            fout << "0x" << std::setw(2) << std::setfill('0') << std::hex << value << ", ";
-            ++bytesInLine;
-            if (bytesInLine == maxBytesInLine) {
-                fout << std::endl;
-                bytesInLine = 0;
-            }
-        }
-    } while (n > 0);
+    bool success = true;
+    std::fputs("#include <cstddef>\n\n", fout);
+    if (mode == "incbin") {
+        std::fprintf(fout, "extern unsigned char %s[];\n\n", arrayName.c_str());
+        // the assembler string sits inside a C string, hence escaped twice
+        std::fprintf(fout,
+                     "__asm__(\n"
+                     "    \".pushsection .data\\n\"\n"
+                     "    \".global %s\\n\"\n"
+                     "    \".balign 16\\n\"\n"
+                     "    \"%s:\\n\"\n"
+                     "    \".incbin \\\"%s\\\"\\n\"\n"
+                     "    \".byte 0\\n\"\n"
+                     "    \".popsection\\n\"\n"
+                     ");\n",
+                     arrayName.c_str(), arrayName.c_str(), escape(absolutePath).c_str());
+    } else if (mode == "embed") {
+        std::fprintf(fout, "%s = {\n#embed \"%s\" suffix(,)\n0x00\n};\n", declaration.c_str(), absolutePath.c_str());
+    } else {
+        std::fprintf(fout, "%s = {\n", declaration.c_str());
+        success = writeArray(fin, fout, !isSource);
+        std::fputs("};\n", fout);
+    }
 
-    fout << "0x" << std::setw(2) << std::setfill('0') << std::hex << 0 << ", ";
-    ++bytesInLine;
-    if (bytesInLine == maxBytesInLine) {
-        fout << std::endl;
-        bytesInLine = 0;
+    if (!isSource) {
+        std::fprintf(fout, "\nstatic const size_t %s_length = sizeof(%s) / sizeof(char);\n", arrayName.c_str(), arrayName.c_str());
     }
 
-    if (bytesInLine > 0)
-        fout << std::endl;
+    std::fclose(fin);
+    success = std::fclose(fout) == 0 && success;
+    std::error_code error;
+    if (!success) {
+        std::cerr << "Can't write file " << tempFilename << "!" << std::endl;
+        fs::remove(tempFilename, error);
+        return 1;
+    }
+    if (!stampFilename.empty() && isSameFile(tempFilename, outputFilename)) {
+        fs::remove(tempFilename, error);
+    } else {
+        fs::rename(tempFilename, outputFilename, error);
+        if (error) {
+            std::cerr << "Can't write file " << outputFilename << "!" << std::endl;
+            fs::remove(tempFilename, error);
+            return 1;
+        }
+    }
 
-    fout << "};" << std::endl;
-    fout << std::endl;
-    fout << "size_t " << arrayName << "_length = sizeof(" << arrayName << ") / sizeof(char);" << std::endl;
+    if (!stampFilename.empty()) {
+        std::ofstream stamp(stampFilename);
+        // opening an existing empty file doesn't update its time everywhere
+        fs::last_write_time(stampFilename, fs::file_time_type::clock::now(), error);
+        if (!stamp || error) {
+            std::cerr << "Can't write file " << stampFilename << "!" << std::endl;
+            return 1;
+        }
 
-    fin.close();
-    fout.close();
+        std::ofstream dep(depFilename);
+        dep << escapeDependency(stampFilename) << ": " << escapeDependency(outputFilename) << "\n";
+        if (!dep) {
+            std::cerr << "Can't write file " << depFilename << "!" << std::endl;
+            return 1;
+        }
+    }
 
     return 0;
 }
-
@@ -0,0 +1,142 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <bitset>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Keys indexed by scancode and mouse buttons, fed from SDL events. Scancodes are physical
+// keys, so WASD stays in place on any layout. Presses and releases are edges since begin_frame.
+// Up to 32 actions can be bound to keys; their state fits one mask to record and replay.
+class input_state {
+public:
+
+    // forgets the edges of the previous frame, call before polling events
+    void begin_frame() {
+        _pressed.reset();
+        _released.reset();
+        _mouse_pressed.reset();
+        _mouse_released.reset();
+        _previous_actions = _actions;
+    }
+
+    void handle(const SDL_Event& event) {
+        switch (event.type) {
+            case SDL_KEYDOWN:
+                set_key(event.key.keysym.scancode, true);
+                break;
+            case SDL_KEYUP:
+                set_key(event.key.keysym.scancode, false);
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+                set_button(event.button.button, true);
+                break;
+            case SDL_MOUSEBUTTONUP:
+                set_button(event.button.button, false);
+                break;
+        }
+    }
+
+    bool is_down(SDL_Scancode key) const {
+        return _down.test(key);
+    }
+
+    // went down this frame, key repeat is ignored
+    bool was_pressed(SDL_Scancode key) const {
+        return _pressed.test(key);
+    }
+
+    bool was_released(SDL_Scancode key) const {
+        return _released.test(key);
+    }
+
+    // SDL_BUTTON_LEFT and so on
+    bool is_button_down(int button) const {
+        return button < max_buttons && _mouse_down.test(button);
+    }
+
+    bool was_button_pressed(int button) const {
+        return button < max_buttons && _mouse_pressed.test(button);
+    }
+
+    bool was_button_released(int button) const {
+        return button < max_buttons && _mouse_released.test(button);
+    }
+
+    // action is down while any of its keys is
+    void bind(int action, SDL_Scancode key) {
+        _bindings.emplace_back(key, action);
+        update_actions();
+    }
+
+    bool is_action_down(int action) const {
+        return (_actions >> action) & 1u;
+    }
+
+    bool was_action_pressed(int action) const {
+        return ((_actions & ~_previous_actions) >> action) & 1u;
+    }
+
+    bool was_action_released(int action) const {
+        return ((~_actions & _previous_actions) >> action) & 1u;
+    }
+
+    // bit per action, stored by recordings
+    std::uint32_t get_actions() const {
+        return _actions;
+    }
+
+    // replaces the actions of this frame with recorded ones, call after handling events
+    void set_actions(std::uint32_t actions) {
+        _actions = actions;
+    }
+
+private:
+
+    static constexpr int max_buttons = 8;
+
+    void set_key(SDL_Scancode key, bool down) {
+        if (key < 0 || key >= SDL_NUM_SCANCODES || _down.test(key) == down) {
+            return;
+        }
+        _down.set(key, down);
+        (down ? _pressed : _released).set(key);
+        update_actions();
+    }
+
+    void set_button(int button, bool down) {
+        if (button >= max_buttons || _mouse_down.test(button) == down) {
+            return;
+        }
+        _mouse_down.set(button, down);
+        (down ? _mouse_pressed : _mouse_released).set(button);
+    }
+
+    void update_actions() {
+        _actions = 0;
+        for (auto [key, action] : _bindings) {
+            if (_down.test(key)) {
+                _actions |= 1u << action;
+            }
+        }
+    }
+
+    std::bitset<SDL_NUM_SCANCODES> _down;
+    std::bitset<SDL_NUM_SCANCODES> _pressed;
+    std::bitset<SDL_NUM_SCANCODES> _released;
+
+    std::bitset<max_buttons> _mouse_down;
+    std::bitset<max_buttons> _mouse_pressed;
+    std::bitset<max_buttons> _mouse_released;
+
+    std::vector<std::pair<SDL_Scancode, int>> _bindings;
+    std::uint32_t _actions = 0;
+    std::uint32_t _previous_actions = 0;
+
+};
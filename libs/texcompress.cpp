@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// Offline block compression of textures with a precomputed mip chain.
+//
+// Container, all fields little-endian uint32:
+//     magic "BCTX", GL internal format, width, height, level count,
+//     then for each level from the largest: byte size, block data.
+//
+// Images are flipped vertically like the runtime loader does, so the blocks
+// are uploaded as they are.
+
+namespace {
+
+const std::uint32_t formatBC1 = 0x83F0; // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+const std::uint32_t formatBC4 = 0x8DBB; // GL_COMPRESSED_RED_RGTC1
+const std::uint32_t formatBC5 = 0x8DBD; // GL_COMPRESSED_RG_RGTC2
+
+enum class Kind {
+    albedo,
+    specular,
+    mask,
+    normal,
+};
+
+struct Image {
+    int width;
+    int height;
+    std::vector<float> pixels; // RGB in [0, 1]
+
+    const float *at(int x, int y) const {
+        x = std::min(x, width - 1);
+        y = std::min(y, height - 1);
+        return pixels.data() + 3 * (y * width + x);
+    }
+};
+
+Image downsample(const Image &src, Kind kind) {
+    Image result;
+    result.width = std::max(1, src.width / 2);
+    result.height = std::max(1, src.height / 2);
+    result.pixels.resize(3 * result.width * result.height);
+    for (int y = 0; y < result.height; ++y) {
+        for (int x = 0; x < result.width; ++x) {
+            float *out = result.pixels.data() + 3 * (y * result.width + x);
+            for (int c = 0; c < 3; ++c) {
+                out[c] = 0.25f * (src.at(2 * x, 2 * y)[c] + src.at(2 * x + 1, 2 * y)[c]
+                    + src.at(2 * x, 2 * y + 1)[c] + src.at(2 * x + 1, 2 * y + 1)[c]);
+            }
+            if (kind == Kind::normal) {
+                // averaged normals get shorter, keep them unit length
+                float n[3] = {2.f * out[0] - 1.f, 2.f * out[1] - 1.f, 2.f * out[2] - 1.f};
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (int c = 0; c < 3 && length > 0.f; ++c) {
+                    out[c] = 0.5f * n[c] / length + 0.5f;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::uint16_t packColor(const float *color) {
+    auto r = (std::uint16_t) std::lround(std::clamp(color[0], 0.f, 1.f) * 31.f);
+    auto g = (std::uint16_t) std::lround(std::clamp(color[1], 0.f, 1.f) * 63.f);
+    auto b = (std::uint16_t) std::lround(std::clamp(color[2], 0.f, 1.f) * 31.f);
+    return (std::uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+std::array<float, 3> unpackColor(std::uint16_t color) {
+    return {
+        (float) ((color >> 11) & 31) / 31.f,
+        (float) ((color >> 5) & 63) / 63.f,
+        (float) (color & 31) / 31.f,
+    };
+}
+
+// endpoints are the extremes of the block along its principal axis
+void encodeBC1(const float (&block)[16][3], std::vector<std::uint8_t> &out) {
+    float mean[3] = {};
+    for (auto &texel : block) {
+        for (int c = 0; c < 3; ++c) {
+            mean[c] += texel[c] / 16.f;
+        }
+    }
+    float covariance[3][3] = {};
+    for (auto &texel : block) {
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+            }
+        }
+    }
+    float axis[3] = {1.f, 1.f, 1.f};
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[3] = {};
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+        }
+        float length = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+        if (length < 1e-12f) {
+            break;
+        }
+        for (int i = 0; i < 3; ++i) {
+            axis[i] = next[i] / length;
+        }
+    }
+
+    float minProjection = INFINITY;
+    float maxProjection = -INFINITY;
+    int minTexel = 0;
+    int maxTexel = 0;
+    for (int i = 0; i < 16; ++i) {
+        float projection = axis[0] * block[i][0] + axis[1] * block[i][1] + axis[2] * block[i][2];
+        if (projection < minProjection) {
+            minProjection = projection;
+            minTexel = i;
+        }
+        if (projection > maxProjection) {
+            maxProjection = projection;
+            maxTexel = i;
+        }
+    }
+
+    std::uint16_t color0 = packColor(block[maxTexel]);
+    std::uint16_t color1 = packColor(block[minTexel]);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    std::uint32_t indices = 0;
+    if (color0 != color1) {
+        // color0 > color1 selects the four color mode
+        auto c0 = unpackColor(color0);
+        auto c1 = unpackColor(color1);
+        float palette[4][3];
+        for (int c = 0; c < 3; ++c) {
+            palette[0][c] = c0[c];
+            palette[1][c] = c1[c];
+            palette[2][c] = (2.f * c0[c] + c1[c]) / 3.f;
+            palette[3][c] = (c0[c] + 2.f * c1[c]) / 3.f;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            float bestDistance = INFINITY;
+            for (int p = 0; p < 4; ++p) {
+                float distance = 0.f;
+                for (int c = 0; c < 3; ++c) {
+                    distance += (block[i][c] - palette[p][c]) * (block[i][c] - palette[p][c]);
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (std::uint32_t) best << (2 * i);
+        }
+    }
+
+    out.push_back(color0 & 0xff);
+    out.push_back(color0 >> 8);
+    out.push_back(color1 & 0xff);
+    out.push_back(color1 >> 8);
+    for (int i = 0; i < 4; ++i) {
+        out.push_back((indices >> (8 * i)) & 0xff);
+    }
+}
+
+void encodeBC4(const float (&values)[16], std::vector<std::uint8_t> &out) {
+    float minValue = *std::min_element(values, values + 16);
+    float maxValue = *std::max_element(values, values + 16);
+    auto red0 = (std::uint8_t) std::lround(std::clamp(maxValue, 0.f, 1.f) * 255.f);
+    auto red1 = (std::uint8_t) std::lround(std::clamp(minValue, 0.f, 1.f) * 255.f);
+
+    std::uint64_t indices = 0;
+    if (red0 != red1) {
+        // red0 > red1 selects eight interpolated values
+        float palette[8] = {red0 / 255.f, red1 / 255.f};
+        for (int p = 2; p < 8; ++p) {
+            palette[p] = ((float) (8 - p) * red0 + (float) (p - 1) * red1) / 7.f / 255.f;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            for (int p = 1; p < 8; ++p) {
+                if (std::abs(values[i] - palette[p]) < std::abs(values[i] - palette[best])) {
+                    best = p;
+                }
+            }
+            indices |= (std::uint64_t) best << (3 * i);
+        }
+    }
+
+    out.push_back(red0);
+    out.push_back(red1);
+    for (int i = 0; i < 6; ++i) {
+        out.push_back((indices >> (8 * i)) & 0xff);
+    }
+}
+
+// BC1 needs EXT_texture_compression_s3tc, on every desktop driver but not core, the hw2
+// loader decodes its blocks when it is missing; BC4 and BC5 are core since 3.0
+std::uint32_t getFormat(Kind kind) {
+    switch (kind) {
+        case Kind::albedo:
+            return formatBC1;
+        case Kind::normal:
+            return formatBC5;
+        default:
+            return formatBC4;
+    }
+}
+
+std::vector<std::uint8_t> encodeLevel(const Image &image, Kind kind) {
+    std::vector<std::uint8_t> result;
+    for (int by = 0; by < image.height; by += 4) {
+        for (int bx = 0; bx < image.width; bx += 4) {
+            float block[16][3];
+            for (int i = 0; i < 16; ++i) {
+                const float *texel = image.at(bx + i % 4, by + i / 4);
+                std::copy(texel, texel + 3, block[i]);
+            }
+            if (kind == Kind::albedo) {
+                encodeBC1(block, result);
+                continue;
+            }
+            // BC5 stores x and y of normals as two BC4 blocks, z is reconstructed
+            int channels = kind == Kind::normal ? 2 : 1;
+            for (int c = 0; c < channels; ++c) {
+                float values[16];
+                for (int i = 0; i < 16; ++i) {
+                    values[i] = block[i][c];
+                }
+                encodeBC4(values, result);
+            }
+        }
+    }
+    return result;
+}
+
+void writeUint(std::ofstream &fout, std::uint32_t value) {
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (char) ((value >> (8 * i)) & 0xff);
+    }
+    fout.write(bytes, 4);
+}
+
+bool compress(const std::string &sourceFilename, const std::string &outputFilename, Kind kind) {
+    int width, height, channels;
+    unsigned char *data = stbi_load(sourceFilename.c_str(), &width, &height, &channels, 3);
+    if (data == nullptr) {
+        std::cerr << "Can't load image " << sourceFilename << "!" << std::endl;
+        return false;
+    }
+
+    Image image{width, height, std::vector<float>(3 * width * height)};
+    for (std::size_t i = 0; i < image.pixels.size(); ++i) {
+        image.pixels[i] = (float) data[i] / 255.f;
+    }
+    stbi_image_free(data);
+
+    std::vector<std::vector<std::uint8_t>> levels;
+    while (true) {
+        levels.push_back(encodeLevel(image, kind));
+        if (image.width == 1 && image.height == 1) {
+            break;
+        }
+        image = downsample(image, kind);
+    }
+
+    std::ofstream fout(outputFilename, std::ios::binary);
+    if (!fout) {
+        std::cerr << "Can't open file " << outputFilename << "!" << std::endl;
+        return false;
+    }
+    fout.write("BCTX", 4);
+    writeUint(fout, getFormat(kind));
+    writeUint(fout, width);
+    writeUint(fout, height);
+    writeUint(fout, (std::uint32_t) levels.size());
+    for (auto &level : levels) {
+        writeUint(fout, (std::uint32_t) level.size());
+        fout.write(reinterpret_cast<const char *>(level.data()), (std::streamsize) level.size());
+    }
+    return true;
+}
+
+// the runtime loader looks for this file next to the image
+std::string getOutputFilename(const std::string &sourceFilename) {
+    auto dot = sourceFilename.rfind('.');
+    auto slash = sourceFilename.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return sourceFilename + ".bctx";
+    }
+    return sourceFilename.substr(0, dot) + ".bctx";
+}
+
+// compresses every texture referenced by the material library, kind is taken from the map type
+bool compressMaterials(const std::string &mtlFilename) {
+    std::ifstream fin(mtlFilename);
+    if (!fin) {
+        std::cerr << "Can't open file " << mtlFilename << "!" << std::endl;
+        return false;
+    }
+
+    std::string dir;
+    if (auto slash = mtlFilename.rfind('/'); slash != std::string::npos) {
+        dir = mtlFilename.substr(0, slash + 1);
+    }
+
+    std::set<std::string> done;
+    bool success = true;
+    std::string line;
+    while (std::getline(fin, line)) {
+        std::istringstream str(line);
+        std::string cmd, name;
+        if (!(str >> cmd >> name)) {
+            continue;
+        }
+
+        Kind kind;
+        if (cmd == "map_Ka" || cmd == "map_Kd") {
+            kind = Kind::albedo;
+        } else if (cmd == "map_Ks") {
+            kind = Kind::specular;
+        } else if (cmd == "map_d") {
+            kind = Kind::mask;
+        } else if (cmd == "norm") {
+            kind = Kind::normal;
+        } else {
+            continue;
+        }
+
+        std::replace(name.begin(), name.end(), '\\', '/');
+        std::string sourceFilename = dir + name;
+        if (!done.insert(sourceFilename).second) {
+            continue;
+        }
+        std::cout << sourceFilename << std::endl;
+        success = compress(sourceFilename, getOutputFilename(sourceFilename), kind) && success;
+    }
+    return success;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    stbi_set_flip_vertically_on_load(1);
+
+    if (argc == 2) {
+        return compressMaterials(argv[1]) ? 0 : 1;
+    }
+
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <mtlFile>" << std::endl;
+        std::cerr << "       " << argv[0] << " albedo|specular|mask|normal <sourceFile> <outputFile>" << std::endl;
+        return 1;
+    }
+
+    std::string kindName(argv[1]);
+    Kind kind;
+    if (kindName == "albedo") {
+        kind = Kind::albedo;
+    } else if (kindName == "specular") {
+        kind = Kind::specular;
+    } else if (kindName == "mask") {
+        kind = Kind::mask;
+    } else if (kindName == "normal") {
+        kind = Kind::normal;
+    } else {
+        std::cerr << "Unknown texture kind " << kindName << "!" << std::endl;
+        return 1;
+    }
+
+    return compress(argv[2], argv[3], kind) ? 0 : 1;
+}
@@ -1,6 +0,0 @@
-namespace glm{
-namespace detail
-{
-
-}//namespace detail
-}//namespace glm
@@ -1,2 +0,0 @@
-/// @ref gtx_raw_data
-
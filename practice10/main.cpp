@@ -10,9 +10,7 @@
 #include <string_view>
 #include <stdexcept>
 #include <iostream>
-#include <chrono>
 #include <vector>
-#include <map>
 #include <cmath>
 #include <fstream>
 #include <sstream>
@@ -27,20 +25,10 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
 
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
+#include "engine/frame_loop.hpp"
+#include "engine/gl_utils.hpp"
+#include "engine/headless_recorder.hpp"
 
 const char vertex_shader_source[] =
 R"(#version 330 core
@@ -120,45 +108,6 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
 struct vertex
 {
 	glm::vec3 position;
@@ -186,41 +135,13 @@ bone_pose operator * (bone_pose const & p1, bone_pose const & p2)
 	return {p1.rotation * p2.rotation, p1.scale * p2.scale, p1.scale * glm::rotate(p1.rotation, p2.translation) + p1.translation};
 }
 
-int main() try
+int main(int argc, char **argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 10",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
+	headless_options headless = parse_headless_options(argc, argv);
+	render_context context(headless.apply({.title = "Graphics course practice 10"}));
 
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	int width = context.get_width();
+	int height = context.get_height();
 
 	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
@@ -323,59 +244,35 @@ int main() try
 
 	static_assert(sizeof(vertex) == 28);
 
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
-
 	float time = 0.f;
 
-	std::map<SDL_Keycode, bool> button_down;
-
 	float view_angle = 0.f;
 	float camera_distance = 3.f;
 	float camera_height = 1.2f;
 
 	float model_rotation = 0.f;
 
-	bool running = true;
-	while (running)
+	frame_loop loop(context);
+	headless_recorder recorder(context, loop, headless);
+	loop.on_resize = [&](int new_width, int new_height)
 	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
-		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
-		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
-			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
-			break;
-		}
+		width = new_width;
+		height = new_height;
+	};
 
-		if (!running)
-			break;
-
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
+	while (loop.next_frame())
+	{
+		float dt = loop.get_dt();
 		time += dt;
 
-		if (button_down[SDLK_UP])
+		if (loop.input.is_down(SDL_SCANCODE_UP))
 			camera_distance -= 3.f * dt;
-		if (button_down[SDLK_DOWN])
+		if (loop.input.is_down(SDL_SCANCODE_DOWN))
 			camera_distance += 3.f * dt;
 
-		if (button_down[SDLK_LEFT])
+		if (loop.input.is_down(SDL_SCANCODE_LEFT))
 			model_rotation -= 3.f * dt;
-		if (button_down[SDLK_RIGHT])
+		if (loop.input.is_down(SDL_SCANCODE_RIGHT))
 			model_rotation += 3.f * dt;
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -432,11 +329,9 @@ int main() try
 		glBindVertexArray(vao);
 		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
 
-		SDL_GL_SwapWindow(window);
+		recorder.capture();
+		loop.end_frame();
 	}
-
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
 }
 catch (std::exception const & e)
 {
@@ -1,10 +0,0 @@
-/// @ref gtx_perpendicular
-
-namespace glm
-{
-	template<typename genType>
-	GLM_FUNC_QUALIFIER genType perp(genType const& x, genType const& Normal)
-	{
-		return x - proj(x, Normal);
-	}
-}//namespace glm
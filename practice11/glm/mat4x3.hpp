@@ -1,8 +0,0 @@
-/// @ref core
-/// @file glm/mat4x3.hpp
-
-#pragma once
-#include "./ext/matrix_double4x3.hpp"
-#include "./ext/matrix_double4x3_precision.hpp"
-#include "./ext/matrix_float4x3.hpp"
-#include "./ext/matrix_float4x3_precision.hpp"
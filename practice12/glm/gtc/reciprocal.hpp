@@ -1,24 +0,0 @@
-/// @ref gtc_reciprocal
-/// @file glm/gtc/reciprocal.hpp
-///
-/// @see core (dependence)
-///
-/// @defgroup gtc_reciprocal GLM_GTC_reciprocal
-/// @ingroup gtc
-///
-/// Include <glm/gtc/reciprocal.hpp> to use the features of this extension.
-///
-/// Define secant, cosecant and cotangent functions.
-
-#pragma once
-
-// Dependencies
-#include "../detail/setup.hpp"
-
-#if GLM_MESSAGES == GLM_ENABLE && !defined(GLM_EXT_INCLUDED)
-#	pragma message("GLM: GLM_GTC_reciprocal extension included")
-#endif
-
-#include "../ext/scalar_reciprocal.hpp"
-#include "../ext/vector_reciprocal.hpp"
-
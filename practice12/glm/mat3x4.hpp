@@ -1,8 +0,0 @@
-/// @ref core
-/// @file glm/mat3x4.hpp
-
-#pragma once
-#include "./ext/matrix_double3x4.hpp"
-#include "./ext/matrix_double3x4_precision.hpp"
-#include "./ext/matrix_float3x4.hpp"
-#include "./ext/matrix_float3x4_precision.hpp"
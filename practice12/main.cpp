@@ -13,9 +13,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
-#include <chrono>
 #include <vector>
-#include <map>
 
 #define GLM_FORCE_SWIZZLE
 #define GLM_ENABLE_EXPERIMENTAL
@@ -27,17 +25,10 @@
 #include <glm/ext/scalar_constants.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-std::string to_string(std::string_view str) {
-    return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message) {
-    throw std::runtime_error(to_string(message) + SDL_GetError());
-}
 
-void glew_fail(std::string_view message, GLenum error) {
-    throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
+#include "engine/frame_loop.hpp"
+#include "engine/gl_utils.hpp"
+#include "engine/headless_recorder.hpp"
 
 const char vertex_shader_source[] =
     R"(#version 330 core
@@ -138,41 +129,6 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char *source) {
-    GLuint result = glCreateShader(type);
-    glShaderSource(result, 1, &source, nullptr);
-    glCompileShader(result);
-    GLint status;
-    glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Shader compilation failed: " + info_log);
-    }
-    return result;
-}
-
-template<typename ... Shaders>
-GLuint create_program(Shaders ... shaders) {
-    GLuint result = glCreateProgram();
-    (glAttachShader(result, shaders), ...);
-    glLinkProgram(result);
-
-    GLint status;
-    glGetProgramiv(result, GL_LINK_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Program linkage failed: " + info_log);
-    }
-
-    return result;
-}
-
 struct vertex {
     glm::vec3 position;
 };
@@ -211,42 +167,12 @@ static std::uint32_t cube_indices[]
         5, 3, 7,
     };
 
-int main() try {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
-        sdl2_fail("SDL_Init: ");
-
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+int main(int argc, char **argv) try {
+    headless_options headless = parse_headless_options(argc, argv);
+    render_context context(headless.apply({.title = "Graphics course practice 12", .samples = 4}));
 
-    SDL_Window *window = SDL_CreateWindow("Graphics course practice 12",
-                                          SDL_WINDOWPOS_CENTERED,
-                                          SDL_WINDOWPOS_CENTERED,
-                                          800, 600,
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-    if (!window)
-        sdl2_fail("SDL_CreateWindow: ");
-
-    int width, height;
-    SDL_GetWindowSize(window, &width, &height);
-
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-    if (!gl_context)
-        sdl2_fail("SDL_GL_CreateContext: ");
-
-    if (auto result = glewInit(); result != GLEW_NO_ERROR)
-        glew_fail("glewInit: ", result);
-
-    if (!GLEW_VERSION_3_3)
-        throw std::runtime_error("OpenGL 3.3 is not supported");
+    int width = context.get_width();
+    int height = context.get_height();
 
     glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
@@ -291,49 +217,25 @@ int main() try {
     glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, 256, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.data());
     glGenerateMipmap(GL_TEXTURE_3D);
 
-    auto last_frame_start = std::chrono::high_resolution_clock::now();
-
     float time = 0.f;
 
     glm::vec3 camera_position{0.f, 0.f, 3.f};
 
     float camera_rotation = 0.f;
 
-    std::map<SDL_Keycode, bool> button_down;
-
-    bool running = true;
     bool paused = false;
-    while (running) {
-        for (SDL_Event event; SDL_PollEvent(&event);)
-            switch (event.type) {
-                case SDL_QUIT:
-                    running = false;
-                    break;
-                case SDL_WINDOWEVENT:
-                    switch (event.window.event) {
-                        case SDL_WINDOWEVENT_RESIZED:
-                            width = event.window.data1;
-                            height = event.window.data2;
-                            glViewport(0, 0, width, height);
-                            break;
-                    }
-                    break;
-                case SDL_KEYDOWN:
-                    button_down[event.key.keysym.sym] = true;
-                    if (event.key.keysym.sym == SDLK_SPACE)
-                        paused = !paused;
-                    break;
-                case SDL_KEYUP:
-                    button_down[event.key.keysym.sym] = false;
-                    break;
-            }
-
-        if (!running)
-            break;
-
-        auto now = std::chrono::high_resolution_clock::now();
-        float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-        last_frame_start = now;
+    frame_loop loop(context);
+    headless_recorder recorder(context, loop, headless);
+    loop.on_resize = [&](int new_width, int new_height) {
+        width = new_width;
+        height = new_height;
+    };
+
+    while (loop.next_frame()) {
+        if (loop.input.was_pressed(SDL_SCANCODE_SPACE))
+            paused = !paused;
+
+        float dt = loop.get_dt();
 
         if (!paused)
             time += dt;
@@ -341,26 +243,26 @@ int main() try {
         float camera_move_forward = 0.f;
         float camera_move_sideways = 0.f;
 
-        if (button_down[SDLK_w])
+        if (loop.input.is_down(SDL_SCANCODE_W))
             camera_move_forward -= 3.f * dt;
-        if (button_down[SDLK_s])
+        if (loop.input.is_down(SDL_SCANCODE_S))
             camera_move_forward += 3.f * dt;
-        if (button_down[SDLK_a])
+        if (loop.input.is_down(SDL_SCANCODE_A))
             camera_move_sideways -= 3.f * dt;
-        if (button_down[SDLK_d])
+        if (loop.input.is_down(SDL_SCANCODE_D))
             camera_move_sideways += 3.f * dt;
 
         camera_position += camera_move_forward * glm::vec3(-std::sin(camera_rotation), 0.f, std::cos(camera_rotation));
         camera_position += camera_move_sideways * glm::vec3(std::cos(camera_rotation), 0.f, std::sin(camera_rotation));
 
-        if (button_down[SDLK_LEFT])
+        if (loop.input.is_down(SDL_SCANCODE_LEFT))
             camera_rotation -= 3.f * dt;
-        if (button_down[SDLK_RIGHT])
+        if (loop.input.is_down(SDL_SCANCODE_RIGHT))
             camera_rotation += 3.f * dt;
 
-        if (button_down[SDLK_DOWN])
+        if (loop.input.is_down(SDL_SCANCODE_DOWN))
             camera_position.y -= 3.f * dt;
-        if (button_down[SDLK_UP])
+        if (loop.input.is_down(SDL_SCANCODE_UP))
             camera_position.y += 3.f * dt;
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -391,11 +293,9 @@ int main() try {
         glBindVertexArray(vao);
         glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
 
-        SDL_GL_SwapWindow(window);
+        recorder.capture();
+        loop.end_frame();
     }
-
-    SDL_GL_DeleteContext(gl_context);
-    SDL_DestroyWindow(window);
 }
 catch (std::exception const &e) {
     std::cerr << e.what() << std::endl;
@@ -10,23 +10,12 @@
 #include <string_view>
 #include <stdexcept>
 #include <iostream>
-#include <chrono>
 #include <vector>
+#include <cmath>
 
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
+#include "engine/frame_loop.hpp"
+#include "engine/gl_utils.hpp"
+#include "engine/headless_recorder.hpp"
 
 const char vertex_shader_source[] =
 R"(#version 330 core
@@ -68,45 +57,6 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
 struct vec2
 {
 	float x;
@@ -159,41 +109,13 @@ void bezier_calc(std::vector<vertex> const & vertices, int quality, std::vector<
     }
 }
 
-int main() try
+int main(int argc, char **argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
+	headless_options headless = parse_headless_options(argc, argv);
+	render_context context(headless.apply({.title = "Graphics course practice 3", .samples = 4, .swap_interval = 0}));
 
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 3",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	SDL_GL_SetSwapInterval(0);
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	int width = context.get_width();
+	int height = context.get_height();
 
 	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
@@ -244,29 +166,22 @@ int main() try
 
     int quality = 4;
 
-    auto last_frame_start = std::chrono::high_resolution_clock::now();
-
 	float time = 0.f;
 
-	bool running = true;
-	while (running)
+    bool vector_changed = false;
+    bool quality_changed = false;
+
+	frame_loop loop(context);
+	headless_recorder recorder(context, loop, headless);
+	loop.on_resize = [&](int new_width, int new_height)
+	{
+		width = new_width;
+		height = new_height;
+	};
+	loop.on_event = [&](const SDL_Event & event)
 	{
-        bool vector_changed = false;
-        bool quality_changed = false;
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
+		switch (event.type)
 		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
 		case SDL_MOUSEBUTTONDOWN:
 			if (event.button.button == SDL_BUTTON_LEFT)
 			{
@@ -301,13 +216,11 @@ int main() try
 			}
 			break;
 		}
+	};
 
-		if (!running)
-			break;
-
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
+	while (loop.next_frame())
+	{
+		float dt = loop.get_dt();
 		time += dt;
 
 		glClear(GL_COLOR_BUFFER_BIT);
@@ -346,11 +259,12 @@ int main() try
         glBindVertexArray(vao_b);
         glDrawArrays(GL_LINE_STRIP, 0, bezier_data.size());
 
-		SDL_GL_SwapWindow(window);
-	}
+        vector_changed = false;
+        quality_changed = false;
 
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+		recorder.capture();
+		loop.end_frame();
+	}
 }
 catch (std::exception const & e)
 {
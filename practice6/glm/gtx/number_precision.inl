@@ -1,6 +0,0 @@
-/// @ref gtx_number_precision
-
-namespace glm
-{
-
-}
@@ -1,37 +0,0 @@
-/// @ref gtx_wrap
-/// @file glm/gtx/wrap.hpp
-///
-/// @see core (dependence)
-///
-/// @defgroup gtx_wrap GLM_GTX_wrap
-/// @ingroup gtx
-///
-/// Include <glm/gtx/wrap.hpp> to use the features of this extension.
-///
-/// Wrapping mode of texture coordinates.
-
-#pragma once
-
-// Dependency:
-#include "../glm.hpp"
-#include "../ext/scalar_common.hpp"
-#include "../ext/vector_common.hpp"
-#include "../gtc/vec1.hpp"
-
-#if GLM_MESSAGES == GLM_ENABLE && !defined(GLM_EXT_INCLUDED)
-#	ifndef GLM_ENABLE_EXPERIMENTAL
-#		pragma message("GLM: GLM_GTX_wrap is an experimental extension and may change in the future. Use #define GLM_ENABLE_EXPERIMENTAL before including it, if you really want to use it.")
-#	else
-#		pragma message("GLM: GLM_GTX_wrap extension included")
-#	endif
-#endif
-
-namespace glm
-{
-	/// @addtogroup gtx_wrap
-	/// @{
-
-	/// @}
-}// namespace glm
-
-#include "wrap.inl"
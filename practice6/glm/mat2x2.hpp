@@ -1,9 +0,0 @@
-/// @ref core
-/// @file glm/mat2x2.hpp
-
-#pragma once
-#include "./ext/matrix_double2x2.hpp"
-#include "./ext/matrix_double2x2_precision.hpp"
-#include "./ext/matrix_float2x2.hpp"
-#include "./ext/matrix_float2x2_precision.hpp"
-
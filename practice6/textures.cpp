@@ -0,0 +1,15 @@
+#include "textures.hpp"
+
+// pixel data is generated from textures/raw by convertIntoSource
+
+unsigned int brick_albedo_width = 1024;
+unsigned int brick_albedo_height = 1024;
+
+unsigned int brick_normal_width = 1024;
+unsigned int brick_normal_height = 1024;
+
+unsigned int brick_roughness_width = 1024;
+unsigned int brick_roughness_height = 1024;
+
+unsigned int brick_ao_width = 1024;
+unsigned int brick_ao_height = 1024;
@@ -1,9 +0,0 @@
-/// @ref core
-/// @file glm/mat2x3.hpp
-
-#pragma once
-#include "./ext/matrix_double2x3.hpp"
-#include "./ext/matrix_double2x3_precision.hpp"
-#include "./ext/matrix_float2x3.hpp"
-#include "./ext/matrix_float2x3_precision.hpp"
-
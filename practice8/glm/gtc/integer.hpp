@@ -1,43 +0,0 @@
-/// @ref gtc_integer
-/// @file glm/gtc/integer.hpp
-///
-/// @see core (dependence)
-/// @see gtc_integer (dependence)
-///
-/// @defgroup gtc_integer GLM_GTC_integer
-/// @ingroup gtc
-///
-/// Include <glm/gtc/integer.hpp> to use the features of this extension.
-///
-/// @brief Allow to perform bit operations on integer values
-
-#pragma once
-
-// Dependencies
-#include "../detail/setup.hpp"
-#include "../detail/qualifier.hpp"
-#include "../common.hpp"
-#include "../integer.hpp"
-#include "../exponential.hpp"
-#include "../ext/scalar_common.hpp"
-#include "../ext/vector_common.hpp"
-#include <limits>
-
-#if GLM_MESSAGES == GLM_ENABLE && !defined(GLM_EXT_INCLUDED)
-#	pragma message("GLM: GLM_GTC_integer extension included")
-#endif
-
-namespace glm
-{
-	/// @addtogroup gtc_integer
-	/// @{
-
-	/// Returns the log2 of x for integer values. Usefull to compute mipmap count from the texture size.
-	/// @see gtc_integer
-	template<typename genIUType>
-	GLM_FUNC_DECL genIUType log2(genIUType x);
-
-	/// @}
-} //namespace glm
-
-#include "integer.inl"
@@ -12,9 +12,7 @@
 #include <string_view>
 #include <stdexcept>
 #include <iostream>
-#include <chrono>
 #include <vector>
-#include <map>
 #include <cmath>
 #include <fstream>
 #include <sstream>
@@ -30,17 +28,9 @@
 #include <glm/gtx/string_cast.hpp>
 #include <ntdef.h>
 
-std::string to_string(std::string_view str) {
-    return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message) {
-    throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error) {
-    throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
+#include "engine/frame_loop.hpp"
+#include "engine/gl_utils.hpp"
+#include "engine/headless_recorder.hpp"
 
 const char vertex_shader_source[] =
     R"(#version 330 core
@@ -239,41 +229,6 @@ void main()
 
 )";
 
-GLuint create_shader(GLenum type, const char *source) {
-    GLuint result = glCreateShader(type);
-    glShaderSource(result, 1, &source, nullptr);
-    glCompileShader(result);
-    GLint status;
-    glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Shader compilation failed: " + info_log);
-    }
-    return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader) {
-    GLuint result = glCreateProgram();
-    glAttachShader(result, vertex_shader);
-    glAttachShader(result, fragment_shader);
-    glLinkProgram(result);
-
-    GLint status;
-    glGetProgramiv(result, GL_LINK_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Program linkage failed: " + info_log);
-    }
-
-    return result;
-}
-
 struct vertex {
     glm::vec3 position;
     glm::vec3 normal;
@@ -380,40 +335,12 @@ void fill_normals(std::vector<vertex> &vertices, std::vector<std::uint32_t> cons
         v.normal = glm::normalize(v.normal);
 }
 
-int main() try {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
-        sdl2_fail("SDL_Init: ");
+int main(int argc, char **argv) try {
+    headless_options headless = parse_headless_options(argc, argv);
+    render_context context(headless.apply({.title = "Graphics course practice 9"}));
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-    SDL_Window *window = SDL_CreateWindow("Graphics course practice 9",
-                                          SDL_WINDOWPOS_CENTERED,
-                                          SDL_WINDOWPOS_CENTERED,
-                                          800, 600,
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-    if (!window)
-        sdl2_fail("SDL_CreateWindow: ");
-
-    int width, height;
-    SDL_GetWindowSize(window, &width, &height);
-
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-    if (!gl_context)
-        sdl2_fail("SDL_GL_CreateContext: ");
-
-    if (auto result = glewInit(); result != GLEW_NO_ERROR)
-        glew_fail("glewInit: ", result);
-
-    if (!GLEW_VERSION_3_3)
-        throw std::runtime_error("OpenGL 3.3 is not supported");
+    int width = context.get_width();
+    int height = context.get_height();
 
     auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
     auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
@@ -542,13 +469,9 @@ int main() try {
 
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-    auto last_frame_start = std::chrono::high_resolution_clock::now();
-
     float time = 0.f;
     bool paused = false;
 
-    std::map<SDL_Keycode, bool> button_down;
-
     auto[bbox_min, bbox_max] = bbox(vertices);
     glm::vec3 bbox_center = (bbox_min + bbox_max) * glm::vec3(0.5);
 
@@ -556,51 +479,29 @@ int main() try {
     float view_azimuth = 0.f;
     float camera_distance = 0.5f;
     float camera_target = 0.05f;
-    bool running = true;
-    while (running) {
-        for (SDL_Event event; SDL_PollEvent(&event);)
-            switch (event.type) {
-                case SDL_QUIT:
-                    running = false;
-                    break;
-                case SDL_WINDOWEVENT:
-                    switch (event.window.event) {
-                        case SDL_WINDOWEVENT_RESIZED:
-                            width = event.window.data1;
-                            height = event.window.data2;
-                            glViewport(0, 0, width, height);
-                            break;
-                    }
-                    break;
-                case SDL_KEYDOWN:
-                    button_down[event.key.keysym.sym] = true;
-
-                    if (event.key.keysym.sym == SDLK_SPACE)
-                        paused = !paused;
-
-                    break;
-                case SDL_KEYUP:
-                    button_down[event.key.keysym.sym] = false;
-                    break;
-            }
-
-        if (!running)
-            break;
-
-        auto now = std::chrono::high_resolution_clock::now();
-        float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-        last_frame_start = now;
+    frame_loop loop(context);
+    headless_recorder recorder(context, loop, headless);
+    loop.on_resize = [&](int new_width, int new_height) {
+        width = new_width;
+        height = new_height;
+    };
+
+    while (loop.next_frame()) {
+        if (loop.input.was_pressed(SDL_SCANCODE_SPACE))
+            paused = !paused;
+
+        float dt = loop.get_dt();
         if (!paused)
             time += dt;
 
-        if (button_down[SDLK_UP])
+        if (loop.input.is_down(SDL_SCANCODE_UP))
             camera_distance -= 1.f * dt;
-        if (button_down[SDLK_DOWN])
+        if (loop.input.is_down(SDL_SCANCODE_DOWN))
             camera_distance += 1.f * dt;
 
-        if (button_down[SDLK_LEFT])
+        if (loop.input.is_down(SDL_SCANCODE_LEFT))
             view_azimuth -= 2.f * dt;
-        if (button_down[SDLK_RIGHT])
+        if (loop.input.is_down(SDL_SCANCODE_RIGHT))
             view_azimuth += 2.f * dt;
 
         glm::mat4 model(1.f);
@@ -713,11 +614,9 @@ int main() try {
         glBindVertexArray(debug_vao);
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
-        SDL_GL_SwapWindow(window);
+        recorder.capture();
+        loop.end_frame();
     }
-
-    SDL_GL_DeleteContext(gl_context);
-    SDL_DestroyWindow(window);
 }
 catch (std::exception const &e) {
     std::cerr << e.what() << std::endl;